@@ -0,0 +1,419 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include "attest.h"
+#include "crypto_helpers.h"
+#include "stage_profile.h"
+
+/** the BIP32 path of the key the attestation MAC key is derived from, m/44'/888'/'ATST'. */
+static const unsigned int attest_key_path[] = {0x80000000 | 44, 0x80000000 | 888, 0xC1545354};
+
+/** what the streaming parser of a previous transaction expects next. */
+enum ATTEST_STATE {
+    ATTEST_IDLE,
+    ATTEST_OUTPUT_INDEX,
+    ATTEST_TYPE,
+    ATTEST_VERSION,
+    ATTEST_CLAIM_COUNT,
+    ATTEST_SCRIPT_LEN,
+    ATTEST_ATTR_COUNT,
+    ATTEST_ATTR_USAGE,
+    ATTEST_ATTR_URL_LEN,
+    ATTEST_ATTR_DATA_LEN,
+    ATTEST_INPUT_COUNT,
+    ATTEST_OUTPUT_COUNT,
+    ATTEST_OUTPUTS,
+    ATTEST_DONE
+};
+
+/** the state of the streaming parser. it is only as large as one output, so a previous transaction
+ * of any size can be attested. */
+static struct {
+    /** the hash of the previous transaction so far. */
+    cx_sha256_t hash;
+
+    /** what the parser expects next. */
+    unsigned char state;
+
+    /** the type of the previous transaction. */
+    unsigned char tx_type;
+
+    /** the version of the previous transaction. */
+    unsigned char version;
+
+    /** bytes left to skip before the next field. */
+    unsigned int skip_len;
+
+    /** bytes left to read of the current variable length number, or of the output index. */
+    unsigned char num_bytes_left;
+
+    /** position in the current variable length number, or in the output index. */
+    unsigned char num_shift;
+
+    /** the variable length number being read. */
+    uint32_t num;
+
+    /** attributes or outputs left to read. */
+    uint32_t count_left;
+
+    /** index of the attested output. */
+    uint16_t output_index;
+
+    /** index of the output being read. */
+    uint32_t output_ix;
+
+    /** bytes read of the output being read. */
+    unsigned char output_fill;
+
+    /** the attested output, once read. */
+    unsigned char output[TX_OUTPUT_LEN];
+} attest_parser;
+
+/** the attestations loaded for the next transaction to sign. */
+static attested_input_t attested_inputs[MAX_ATTESTED_INPUTS];
+
+/** number of attestations in attested_inputs. */
+static unsigned char attested_input_count;
+
+/** the MAC key, derived from the seed so attestations stay valid when the app restarts. */
+static unsigned char attest_mac_key[CX_SHA256_SIZE];
+
+/** true once attest_mac_key has been derived. */
+static bool attest_mac_key_ready;
+
+/** stop the streaming parser, the previous transaction has to be sent again. */
+static unsigned short attest_fail(void) {
+    attest_parser.state = ATTEST_IDLE;
+    return 0x6D1A;
+}
+
+/** writes the MAC of the coin reference, asset id and value at the start of an attestation. */
+static unsigned short attest_mac(const unsigned char *attestation, unsigned char *mac) {
+    if (!attest_mac_key_ready) {
+        cx_ecfp_private_key_t private_key;
+        PROFILE_STAGE(STAGE_DERIVE, 0);
+        if (bip32_derive_init_privkey_256(CX_CURVE_256R1,
+                                          attest_key_path,
+                                          sizeof(attest_key_path) / sizeof(attest_key_path[0]),
+                                          &private_key,
+                                          NULL) != CX_OK) {
+            explicit_bzero(&private_key, sizeof(private_key));
+            return 0x6D00;
+        }
+        cx_hash_sha256(private_key.d, private_key.d_len, attest_mac_key, sizeof(attest_mac_key));
+        explicit_bzero(&private_key, sizeof(private_key));
+        attest_mac_key_ready = true;
+    }
+
+    if (cx_hmac_sha256(attest_mac_key,
+                       sizeof(attest_mac_key),
+                       attestation,
+                       ATTESTATION_LEN - ATTEST_MAC_LEN,
+                       mac,
+                       ATTEST_MAC_LEN) != CX_OK) {
+        return 0x6D00;
+    }
+    return SW_OK;
+}
+
+/** the parser expects a variable length number in state. */
+static void expect_num(enum ATTEST_STATE state) {
+    attest_parser.state = state;
+    attest_parser.num = 0;
+    attest_parser.num_bytes_left = 0;
+    attest_parser.num_shift = 0;
+}
+
+/** the parser read the attribute, either go on to the next one or to the inputs. */
+static void next_attr(void) {
+    attest_parser.count_left--;
+    if (attest_parser.count_left == 0) {
+        expect_num(ATTEST_INPUT_COUNT);
+    } else {
+        attest_parser.state = ATTEST_ATTR_USAGE;
+    }
+}
+
+/** the parser read the variable length number of its state. */
+static unsigned short on_num(uint32_t num) {
+    switch (attest_parser.state) {
+        case ATTEST_CLAIM_COUNT:
+            attest_parser.skip_len = num * COIN_REFERENCES_LEN;
+            expect_num(ATTEST_ATTR_COUNT);
+            break;
+        case ATTEST_SCRIPT_LEN:
+            // UInt64.SIZE = 8
+            attest_parser.skip_len = num + ((attest_parser.version >= 1) ? 8 : 0);
+            expect_num(ATTEST_ATTR_COUNT);
+            break;
+        case ATTEST_ATTR_COUNT:
+            attest_parser.count_left = num;
+            if (num == 0) {
+                expect_num(ATTEST_INPUT_COUNT);
+            } else {
+                attest_parser.state = ATTEST_ATTR_USAGE;
+            }
+            break;
+        case ATTEST_ATTR_DATA_LEN:
+            attest_parser.skip_len = num;
+            next_attr();
+            break;
+        case ATTEST_INPUT_COUNT:
+            attest_parser.skip_len = num * COIN_REFERENCES_LEN;
+            expect_num(ATTEST_OUTPUT_COUNT);
+            break;
+        case ATTEST_OUTPUT_COUNT:
+            if (attest_parser.output_index >= num) {
+                return attest_fail();
+            }
+            attest_parser.count_left = num;
+            attest_parser.output_ix = 0;
+            attest_parser.output_fill = 0;
+            attest_parser.state = ATTEST_OUTPUTS;
+            break;
+        default:
+            return attest_fail();
+    }
+    return SW_OK;
+}
+
+/** the parser read the usage of an attribute, skip over its data. */
+static unsigned short on_attr_usage(enum TransactionAttributeUsage attr_usage) {
+    switch (attr_usage) {
+        case CONTRACT_HASH:
+        case VOTE:
+        case ECDH02:
+        case ECDH03:
+            attest_parser.skip_len = 32;
+            next_attr();
+            break;
+
+        case SCRIPT:
+            attest_parser.skip_len = 20;
+            next_attr();
+            break;
+
+        case DESCRIPTION_URL:
+            attest_parser.state = ATTEST_ATTR_URL_LEN;
+            break;
+
+        case DESCRIPTION:
+            expect_num(ATTEST_ATTR_DATA_LEN);
+            break;
+
+        default:
+            if ((attr_usage >= HASH1) && (attr_usage <= HASH15)) {
+                attest_parser.skip_len = 32;
+                next_attr();
+            } else if (attr_usage >= REMARK) {
+                expect_num(ATTEST_ATTR_DATA_LEN);
+            } else {
+                return attest_fail();
+            }
+    }
+    return SW_OK;
+}
+
+/** feed one byte of the previous transaction to the parser. */
+static unsigned short attest_byte(unsigned char b) {
+    if (attest_parser.skip_len > 0) {
+        attest_parser.skip_len--;
+        return SW_OK;
+    }
+
+    switch (attest_parser.state) {
+        case ATTEST_OUTPUT_INDEX:
+            attest_parser.output_index |= b << attest_parser.num_shift;
+            attest_parser.num_shift += 8;
+            if (attest_parser.num_shift == 16) {
+                attest_parser.state = ATTEST_TYPE;
+            }
+            return SW_OK;
+
+        case ATTEST_TYPE:
+            // only the types whose exclusive data the parser can skip.
+            if ((b != TX_MINER) && (b != TX_ISSUE) && (b != TX_CLAIM) && (b != TX_CONTRACT) &&
+                (b != TX_INVOKE)) {
+                return attest_fail();
+            }
+            attest_parser.tx_type = b;
+            attest_parser.state = ATTEST_VERSION;
+            return SW_OK;
+
+        case ATTEST_VERSION:
+            attest_parser.version = b;
+            // the exclusive data.
+            if (attest_parser.tx_type == TX_CLAIM) {
+                expect_num(ATTEST_CLAIM_COUNT);
+            } else if (attest_parser.tx_type == TX_INVOKE) {
+                expect_num(ATTEST_SCRIPT_LEN);
+            } else {
+                if (attest_parser.tx_type == TX_MINER) {
+                    // the nonce.
+                    attest_parser.skip_len = 4;
+                }
+                expect_num(ATTEST_ATTR_COUNT);
+            }
+            return SW_OK;
+
+        case ATTEST_CLAIM_COUNT:
+        case ATTEST_SCRIPT_LEN:
+        case ATTEST_ATTR_COUNT:
+        case ATTEST_ATTR_DATA_LEN:
+        case ATTEST_INPUT_COUNT:
+        case ATTEST_OUTPUT_COUNT:
+            // variable length numbers: one byte, or 0xFD then two bytes, or 0xFE then four.
+            if (attest_parser.num_bytes_left == 0) {
+                if (b < 0xFD) {
+                    return on_num(b);
+                } else if (b == 0xFD) {
+                    attest_parser.num_bytes_left = 2;
+                } else if (b == 0xFE) {
+                    attest_parser.num_bytes_left = 4;
+                } else {
+                    return attest_fail();
+                }
+                return SW_OK;
+            }
+            attest_parser.num |= ((uint32_t) b) << attest_parser.num_shift;
+            attest_parser.num_shift += 8;
+            attest_parser.num_bytes_left--;
+            if (attest_parser.num_bytes_left == 0) {
+                // bound the counts so the skip lengths can not overflow.
+                if (attest_parser.num > 0xFFFF) {
+                    return attest_fail();
+                }
+                return on_num(attest_parser.num);
+            }
+            return SW_OK;
+
+        case ATTEST_ATTR_USAGE:
+            return on_attr_usage(b);
+
+        case ATTEST_ATTR_URL_LEN:
+            attest_parser.skip_len = b;
+            next_attr();
+            return SW_OK;
+
+        case ATTEST_OUTPUTS:
+            if (attest_parser.output_ix == attest_parser.output_index) {
+                attest_parser.output[attest_parser.output_fill] = b;
+            }
+            attest_parser.output_fill++;
+            if (attest_parser.output_fill == TX_OUTPUT_LEN) {
+                attest_parser.output_fill = 0;
+                attest_parser.output_ix++;
+                if (attest_parser.output_ix == attest_parser.count_left) {
+                    attest_parser.state = ATTEST_DONE;
+                }
+            }
+            return SW_OK;
+
+        default:
+            // the scripts are not part of the transaction id, nothing may follow the outputs.
+            return attest_fail();
+    }
+}
+
+/** parse the next len bytes of a previous transaction streamed for attestation. the first part
+ * starts with the index of the attested output. only the unsigned transaction is sent, as the
+ * transaction id does not cover the scripts. */
+unsigned short attest_stream(const unsigned char *in, unsigned int len, bool first) {
+    if (first) {
+        memset(&attest_parser, 0, sizeof(attest_parser));
+        cx_sha256_init(&attest_parser.hash);
+        attest_parser.state = ATTEST_OUTPUT_INDEX;
+    } else if (attest_parser.state == ATTEST_IDLE) {
+        return 0x6D1A;
+    }
+
+    unsigned int in_ix = 0;
+    // the output index is not part of the previous transaction.
+    while ((in_ix < len) && (attest_parser.state == ATTEST_OUTPUT_INDEX)) {
+        CHECK_SW(attest_byte(in[in_ix++]));
+    }
+    if (cx_hash_no_throw(&attest_parser.hash.header, 0, in + in_ix, len - in_ix, NULL, 0) !=
+        CX_OK) {
+        return attest_fail();
+    }
+    while (in_ix < len) {
+        CHECK_SW(attest_byte(in[in_ix++]));
+    }
+    return SW_OK;
+}
+
+/** finish the streamed previous transaction, write its attestation to out and its length to
+ * out_len. */
+unsigned short attest_stream_finish(unsigned char *out, unsigned int *out_len) {
+    if ((attest_parser.state != ATTEST_DONE) || (attest_parser.skip_len != 0)) {
+        return attest_fail();
+    }
+    attest_parser.state = ATTEST_IDLE;
+
+    // the transaction id is the double SHA-256 of the transaction.
+    unsigned char hash[CX_SHA256_SIZE];
+    if (cx_hash_no_throw(&attest_parser.hash.header, CX_LAST, NULL, 0, hash, sizeof(hash)) !=
+        CX_OK) {
+        return 0x6D00;
+    }
+    unsigned int out_ix = 0;
+    cx_hash_sha256(hash, sizeof(hash), out, CX_SHA256_SIZE);
+    out_ix += CX_SHA256_SIZE;
+    out[out_ix++] = attest_parser.output_index & 0xFF;
+    out[out_ix++] = attest_parser.output_index >> 8;
+
+    // the asset id and value of the output, not its script hash.
+    memmove(out + out_ix, attest_parser.output, ASSET_ID_LEN + VALUE_LEN);
+    out_ix += ASSET_ID_LEN + VALUE_LEN;
+
+    CHECK_SW(attest_mac(out, out + out_ix));
+    out_ix += ATTEST_MAC_LEN;
+    *out_len = out_ix;
+    return SW_OK;
+}
+
+/** check the MAC of an attestation and load it for the next transaction to sign. */
+unsigned short attest_load(const unsigned char *in, unsigned int len) {
+    if (len != ATTESTATION_LEN) {
+        return 0x6D1B;
+    }
+
+    unsigned char mac[ATTEST_MAC_LEN];
+    CHECK_SW(attest_mac(in, mac));
+    if (os_secure_memcmp(mac, in + ATTESTATION_LEN - ATTEST_MAC_LEN, sizeof(mac)) != 0) {
+        return 0x6D1B;
+    }
+
+    // loading the same attestation twice does not count its input twice.
+    if (attest_find_input(in) != NULL) {
+        return SW_OK;
+    }
+    if (attested_input_count >= MAX_ATTESTED_INPUTS) {
+        return 0x6D1C;
+    }
+
+    attested_input_t *input = &attested_inputs[attested_input_count++];
+    memmove(input->coin_reference, in, COIN_REFERENCES_LEN);
+    input->asset_label = get_asset_label(in + COIN_REFERENCES_LEN);
+    input->value = value_to_uint64(in + COIN_REFERENCES_LEN + ASSET_ID_LEN);
+    return SW_OK;
+}
+
+/** find the loaded attestation of coin_reference, NULL if there is none. */
+const attested_input_t *attest_find_input(const unsigned char *coin_reference) {
+    for (unsigned char input_ix = 0; input_ix < attested_input_count; input_ix++) {
+        if (memcmp(attested_inputs[input_ix].coin_reference,
+                   coin_reference,
+                   COIN_REFERENCES_LEN) == 0) {
+            return &attested_inputs[input_ix];
+        }
+    }
+    return NULL;
+}
+
+/** drop the loaded attestations. */
+void attest_clear_inputs(void) {
+    memset(attested_inputs, 0, sizeof(attested_inputs));
+    attested_input_count = 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef ATTEST_H
+#define ATTEST_H
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "ui.h"
+#include "neo.h"
+
+/** for input attestation, a part of the previous transaction, P2 tells if it is the first. */
+#define P1_ATTEST_STREAM_MORE P1_MORE
+
+/** for input attestation, the last part of the previous transaction, the attestation is sent
+ * back. */
+#define P1_ATTEST_STREAM_LAST P1_LAST
+
+/** for input attestation, loads an attestation for the next transaction to sign. */
+#define P1_ATTEST_LOAD 0x01
+
+/** for input attestation, drops the loaded attestations. */
+#define P1_ATTEST_CLEAR 0x02
+
+/** for a streamed part, P2 of the first part of the previous transaction, which starts with the
+ * index of the attested output, two bytes little endian like a coin reference. */
+#define P2_ATTEST_FIRST 0x01
+
+/** length of the MAC of an attestation. */
+#define ATTEST_MAC_LEN CX_SHA256_SIZE
+
+/** length of an attestation: <coin reference> <asset id> <value> <mac> */
+#define ATTESTATION_LEN (COIN_REFERENCES_LEN + ASSET_ID_LEN + VALUE_LEN + ATTEST_MAC_LEN)
+
+/** max number of attestations loaded for a transaction. */
+#if defined(TARGET_NANOS)
+#define MAX_ATTESTED_INPUTS 2
+#else
+#define MAX_ATTESTED_INPUTS 8
+#endif
+
+/** an attested output of a previous transaction, loaded for the next transaction to sign. */
+typedef struct {
+    /** the coin reference of the output: the previous transaction id and the output index. */
+    unsigned char coin_reference[COIN_REFERENCES_LEN];
+
+    /** the label of the output's asset. */
+    unsigned char asset_label;
+
+    /** the value of the output. */
+    uint64_t value;
+} attested_input_t;
+
+/** parse the next len bytes of a previous transaction streamed for attestation. the first part
+ * starts with the index of the attested output. returns 0x6D1A if it can not be attested. */
+unsigned short attest_stream(const unsigned char *in, unsigned int len, bool first);
+
+/** finish the streamed previous transaction, write its attestation to out and its length to
+ * out_len. */
+unsigned short attest_stream_finish(unsigned char *out, unsigned int *out_len);
+
+/** check the MAC of an attestation and load it for the next transaction to sign. */
+unsigned short attest_load(const unsigned char *in, unsigned int len);
+
+/** find the loaded attestation of coin_reference, NULL if there is none. */
+const attested_input_t *attest_find_input(const unsigned char *coin_reference);
+
+/** drop the loaded attestations. */
+void attest_clear_inputs(void);
+
+#endif  // ATTEST_H
@@ -0,0 +1,150 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include "batch.h"
+#include "crypto_helpers.h"
+#include "stage_profile.h"
+
+/** the current batch. */
+batch_t batch;
+
+/** true if every output of the transaction just parsed from raw_tx is shown by the batch review.
+ * the review only shows the first output, so the others must be change to the signing key, whose
+ * BIP44 path ends raw_tx. */
+static bool batch_shows_all_outputs(unsigned int raw_tx_len_except_bip44) {
+    if (tx_summary.num_tx_outs <= 1) {
+        return true;
+    }
+
+    // display_tx_desc read the outputs, only check that they end before the BIP44 path.
+    if (tx_summary.tx_outs_ix + (tx_summary.num_tx_outs * (unsigned int) TX_OUTPUT_LEN) >
+        raw_tx_len_except_bip44) {
+        return false;
+    }
+
+    const unsigned char *bip44_in = raw_tx + raw_tx_len_except_bip44;
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    for (uint32_t i = 0; i < BIP44_PATH_LEN; i++) {
+        bip44_path[i] =
+            (bip44_in[0] << 24) | (bip44_in[1] << 16) | (bip44_in[2] << 8) | (bip44_in[3]);
+        bip44_in += 4;
+    }
+
+    uint8_t raw_pubkey[65];
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    if (bip32_derive_get_pubkey_256(CX_CURVE_256R1,
+                                    bip44_path,
+                                    BIP44_PATH_LEN,
+                                    raw_pubkey,
+                                    NULL,
+                                    CX_SHA512) != CX_OK) {
+        return false;
+    }
+    unsigned char change_script_hash[SCRIPT_HASH_LEN];
+    public_key_to_script_hash(raw_pubkey, change_script_hash);
+
+    const unsigned char *tx_out = raw_tx + tx_summary.tx_outs_ix + TX_OUTPUT_LEN;
+    for (unsigned char out_ix = 1; out_ix < tx_summary.num_tx_outs; out_ix++) {
+        const unsigned char *script_hash = tx_out + ASSET_ID_LEN + VALUE_LEN;
+        tx_out += TX_OUTPUT_LEN;
+        if (memcmp(script_hash, change_script_hash, SCRIPT_HASH_LEN) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** queue the transaction just parsed from raw_tx, writes its index in the batch to batch_ix. the
+ * transaction is hashed right away so that raw_tx is free for the next one. */
+unsigned short batch_add_tx(unsigned char *batch_ix) {
+    // a transaction received after an approval starts a new batch.
+    if (batch.approved) {
+        batch_clear();
+    }
+
+    if (batch.count >= MAX_BATCH_TXS) {
+        return 0x6D15;
+    }
+
+    if (raw_tx_len < BIP44_BYTE_LENGTH) {
+        return 0x6D08;
+    }
+    unsigned int raw_tx_len_except_bip44 = raw_tx_len - BIP44_BYTE_LENGTH;
+    if (!batch_shows_all_outputs(raw_tx_len_except_bip44)) {
+        return 0x6D22;
+    }
+
+    batch_tx_t *batch_tx = &batch.txs[batch.count];
+    if (cx_hash_no_throw(&session.tx_hash.header,
+                         CX_LAST,
+                         raw_tx,
+                         raw_tx_len_except_bip44,
+                         batch_tx->hash,
+                         sizeof(batch_tx->hash)) != CX_OK) {
+        return 0x6D00;
+    }
+    memmove(batch_tx->bip44_path, raw_tx + raw_tx_len_except_bip44, BIP44_BYTE_LENGTH);
+    memmove(&batch_tx->summary, &tx_summary, sizeof(tx_summary));
+
+    *batch_ix = batch.count++;
+    return SW_OK;
+}
+
+/** fill the tx_desc screens with the summaries of the batch. */
+unsigned short batch_display_desc(void) {
+    for (unsigned char batch_ix = 0; batch_ix < batch.count; batch_ix++) {
+        CHECK_SW(display_batch_tx_desc(batch_ix, batch.count, &batch.txs[batch_ix].summary));
+    }
+    start_tx_desc(2 * batch.count);
+    return SW_OK;
+}
+
+/** sign the transaction at batch_ix of an approved batch into G_io_apdu_buffer, writes the length
+ * of the signature to tx. */
+unsigned short batch_sign(unsigned char batch_ix, unsigned int *tx) {
+    if ((!batch.approved) || (batch_ix >= batch.count)) {
+        return 0x6D17;
+    }
+
+    /** BIP44 path, used to derive the private key from the mnemonic by calling
+     * os_perso_derive_node_bip32. */
+    const unsigned char *bip44_in = batch.txs[batch_ix].bip44_path;
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    uint32_t i;
+    for (i = 0; i < BIP44_PATH_LEN; i++) {
+        bip44_path[i] =
+            (bip44_in[0] << 24) | (bip44_in[1] << 16) | (bip44_in[2] << 8) | (bip44_in[3]);
+        bip44_in += 4;
+    }
+
+    cx_ecfp_private_key_t private_key;
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    cx_err_t error =
+        bip32_derive_init_privkey_256(CX_CURVE_256R1, bip44_path, BIP44_PATH_LEN, &private_key, NULL);
+
+    // the signature goes first in the response, which leaves room for the status word.
+    size_t sig_len = MAX_DER_SIG_LEN;
+    if (error == CX_OK) {
+        PROFILE_STAGE(STAGE_SIGN, sizeof(batch.txs[batch_ix].hash));
+        error = cx_ecdsa_sign_no_throw(&private_key,
+                                       CX_RND_RFC6979 | CX_LAST,
+                                       CX_SHA256,
+                                       batch.txs[batch_ix].hash,
+                                       sizeof(batch.txs[batch_ix].hash),
+                                       G_io_apdu_buffer,
+                                       &sig_len,
+                                       NULL);
+    }
+    explicit_bzero(&private_key, sizeof(private_key));
+    if (error != CX_OK) {
+        return 0x6D00;
+    }
+    *tx = sig_len;
+    return SW_OK;
+}
+
+/** forget all the transactions of the batch. */
+void batch_clear(void) {
+    explicit_bzero(&batch, sizeof(batch));
+}
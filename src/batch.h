@@ -0,0 +1,68 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "ui.h"
+#include "neo.h"
+
+/** for batch signing, asks for the review of all the transactions of the batch. */
+#define P1_BATCH_REVIEW 0x01
+
+/** for batch signing, asks for the signature of the transaction given in P2. */
+#define P1_BATCH_SIGNATURE 0x02
+
+/** max number of transactions in a batch, each takes two of the MAX_TX_TEXT_SCREENS screens. */
+#if defined(TARGET_NANOS)
+#define MAX_BATCH_TXS 2
+#else
+#define MAX_BATCH_TXS 4
+#endif
+
+/** a transaction of the batch, kept once it has been received. */
+typedef struct {
+    /** the SHA-256 hash of the transaction, which is what gets signed. */
+    unsigned char hash[CX_SHA256_SIZE];
+
+    /** the BIP44 path of the signing key, as received. */
+    unsigned char bip44_path[BIP44_BYTE_LENGTH];
+
+    /** what the review shows of the transaction. */
+    tx_summary_t summary;
+} batch_tx_t;
+
+/** the transactions queued for a single review. */
+typedef struct {
+    batch_tx_t txs[MAX_BATCH_TXS];
+
+    /** number of transactions in txs. */
+    unsigned char count;
+
+    /** true once the user has approved the batch. */
+    bool approved;
+} batch_t;
+
+/** the current batch. */
+extern batch_t batch;
+
+/** queue the transaction just parsed from raw_tx, writes its index in the batch to batch_ix. the
+ * batch review shows the first output of each transaction, so one with other outputs than change to
+ * its signing key is refused. */
+unsigned short batch_add_tx(unsigned char *batch_ix);
+
+/** fill the tx_desc screens with the summaries of the batch, returns the status word. */
+unsigned short batch_display_desc(void);
+
+/** sign the transaction at batch_ix of an approved batch into G_io_apdu_buffer, writes the length
+ * of the signature to tx. */
+unsigned short batch_sign(unsigned char batch_ix, unsigned int *tx);
+
+/** forget all the transactions of the batch. */
+void batch_clear(void);
+
+#endif  // BATCH_H
@@ -0,0 +1,138 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include "dry_run.h"
+
+/** the end of the response, leaving room for the status word. */
+#define DRY_RUN_RESPONSE_END (sizeof(G_io_apdu_buffer) - 2)
+
+/** length of an amount as text: the digits, the decimal point and the terminating null. */
+#define DRY_RUN_AMOUNT_LEN (MAX_TX_TEXT_WIDTH + 2)
+
+/** writes the value as text to amount, and its length to amount_len. */
+static unsigned short amount_to_text(char *amount,
+                                     const unsigned char *value,
+                                     unsigned int *amount_len) {
+    memset(amount, '\0', DRY_RUN_AMOUNT_LEN);
+    CHECK_SW(to_base10_100m(amount, value, DRY_RUN_AMOUNT_LEN));
+    *amount_len = strnlen(amount, DRY_RUN_AMOUNT_LEN);
+    return SW_OK;
+}
+
+/** writes the TLV of output out_ix at the end of the tx bytes response, if it fits. tx is the
+ * response length, before and after, and is left as is if the output does not fit. */
+static unsigned short write_output(unsigned int *tx, unsigned char out_ix) {
+    const unsigned char *asset_id = raw_tx + tx_summary.tx_outs_ix + (out_ix * TX_OUTPUT_LEN);
+    const unsigned char *value = asset_id + ASSET_ID_LEN;
+    const unsigned char *script_hash = value + VALUE_LEN;
+
+    char amount[DRY_RUN_AMOUNT_LEN];
+    unsigned int amount_len;
+    CHECK_SW(amount_to_text(amount, value, &amount_len));
+    char address[ADDRESS_BASE58_LEN + 1];
+    memset(address, '\0', sizeof(address));
+    CHECK_SW(to_address(address, sizeof(address), script_hash));
+    unsigned int address_len = strnlen(address, sizeof(address));
+
+    unsigned int len = 1 + 1 + 1 + amount_len + address_len;
+    if (*tx + 2 + len > DRY_RUN_RESPONSE_END) {
+        return SW_OK;
+    }
+    unsigned char *out = G_io_apdu_buffer + *tx;
+    *out++ = DRY_RUN_TAG_OUTPUT;
+    *out++ = len;
+    *out++ = out_ix;
+    *out++ = get_asset_label(asset_id);
+    *out++ = amount_len;
+    memmove(out, amount, amount_len);
+    out += amount_len;
+    memmove(out, address, address_len);
+    *tx += 2 + len;
+    return SW_OK;
+}
+
+/** writes the TLVs of the outputs from out_ix at the end of the tx bytes response, as many as fit,
+ * followed by the index of the first output left out if any. tx is the response length, before and
+ * after. */
+static unsigned short write_outputs(unsigned int *tx, unsigned char out_ix) {
+    for (; out_ix < tx_summary.num_tx_outs; out_ix++) {
+        unsigned int out_tx = *tx;
+        CHECK_SW(write_output(&out_tx, out_ix));
+        // unless it is the last output, keep room for the index of the next output.
+        bool last = (out_ix + 1 == tx_summary.num_tx_outs);
+        if ((out_tx == *tx) || (!last && (out_tx + 3 > DRY_RUN_RESPONSE_END))) {
+            break;
+        }
+        *tx = out_tx;
+    }
+    if (out_ix < tx_summary.num_tx_outs) {
+        G_io_apdu_buffer[(*tx)++] = DRY_RUN_TAG_NEXT_OUTPUT;
+        G_io_apdu_buffer[(*tx)++] = 1;
+        G_io_apdu_buffer[(*tx)++] = out_ix;
+    }
+    return SW_OK;
+}
+
+/** true if the outputs of the transaction parsed last are all within raw_tx. */
+static bool are_outputs_parsed(void) {
+    return (raw_tx_len != 0) &&
+           (tx_summary.tx_outs_ix + (tx_summary.num_tx_outs * TX_OUTPUT_LEN) <= raw_tx_len);
+}
+
+/** parse the transaction in raw_tx without review or signing, and write what the review would show
+ * to G_io_apdu_buffer as TLVs, with its length in tx. a parse error is not an error of the
+ * instruction, it is reported in the response with the offset the parser stopped at. */
+unsigned short dry_run_tx(unsigned int *tx_out) {
+    unsigned int tx = 0;
+
+    unsigned short sw = display_tx_desc();
+    if ((sw == SW_OK) && !are_outputs_parsed()) {
+        sw = 0x6D05;
+    }
+    if (sw != SW_OK) {
+        G_io_apdu_buffer[tx++] = DRY_RUN_TAG_ERROR;
+        G_io_apdu_buffer[tx++] = 4;
+        G_io_apdu_buffer[tx++] = sw >> 8;
+        G_io_apdu_buffer[tx++] = sw;
+        G_io_apdu_buffer[tx++] = raw_tx_ix >> 8;
+        G_io_apdu_buffer[tx++] = raw_tx_ix;
+        raw_tx_len = 0;
+        *tx_out = tx;
+        return SW_OK;
+    }
+
+    G_io_apdu_buffer[tx++] = DRY_RUN_TAG_TYPE;
+    G_io_apdu_buffer[tx++] = 1;
+    G_io_apdu_buffer[tx++] = tx_summary.tx_type;
+
+    G_io_apdu_buffer[tx++] = DRY_RUN_TAG_OUTPUT_COUNT;
+    G_io_apdu_buffer[tx++] = 1;
+    G_io_apdu_buffer[tx++] = tx_summary.num_tx_outs;
+
+    if (tx_summary.fee_known) {
+        unsigned char value[VALUE_LEN];
+        char fee[DRY_RUN_AMOUNT_LEN];
+        uint64_to_value(value, tx_summary.fee);
+        unsigned int fee_len;
+        CHECK_SW(amount_to_text(fee, value, &fee_len));
+        G_io_apdu_buffer[tx++] = DRY_RUN_TAG_FEE;
+        G_io_apdu_buffer[tx++] = fee_len;
+        memmove(G_io_apdu_buffer + tx, fee, fee_len);
+        tx += fee_len;
+    }
+
+    CHECK_SW(write_outputs(&tx, 0));
+    *tx_out = tx;
+    return SW_OK;
+}
+
+/** write the outputs of the transaction parsed last, starting at out_ix, to G_io_apdu_buffer as
+ * TLVs, with their length in tx. */
+unsigned short dry_run_outputs(unsigned char out_ix, unsigned int *tx) {
+    if (!are_outputs_parsed() || (out_ix >= tx_summary.num_tx_outs)) {
+        return 0x6D20;
+    }
+    *tx = 0;
+    return write_outputs(tx, out_ix);
+}
@@ -0,0 +1,43 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef DRY_RUN_H
+#define DRY_RUN_H
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "ui.h"
+#include "neo.h"
+
+/** for a dry run, asks for the outputs of the parsed transaction, starting at the one in P2. */
+#define P1_DRY_RUN_OUTPUTS 0x01
+
+/** tag of a parse error: <status word, 2 bytes> <offset in the transaction, 2 bytes>. */
+#define DRY_RUN_TAG_ERROR 0x01
+
+/** tag of the transaction type: <type>. */
+#define DRY_RUN_TAG_TYPE 0x02
+
+/** tag of the number of outputs: <count>. */
+#define DRY_RUN_TAG_OUTPUT_COUNT 0x03
+
+/** tag of the fee, when the inputs are attested: <amount text>. */
+#define DRY_RUN_TAG_FEE 0x04
+
+/** tag of an output: <index> <asset label> <amount text length> <amount text> <address>. */
+#define DRY_RUN_TAG_OUTPUT 0x05
+
+/** tag of the index of the first output that did not fit in the response: <index>. */
+#define DRY_RUN_TAG_NEXT_OUTPUT 0x06
+
+/** parse the transaction in raw_tx without review or signing, and write what the review would show
+ * to G_io_apdu_buffer as TLVs, with its length in tx. */
+unsigned short dry_run_tx(unsigned int *tx);
+
+/** write the outputs of the transaction parsed last, starting at out_ix, to G_io_apdu_buffer as
+ * TLVs, with their length in tx. */
+unsigned short dry_run_outputs(unsigned char out_ix, unsigned int *tx);
+
+#endif  // DRY_RUN_H
@@ -23,6 +23,13 @@
 #include "io.h"
 #include "ui.h"
 #include "neo.h"
+#include "batch.h"
+#include "policy.h"
+#include "attest.h"
+#include "swap.h"
+#include "dry_run.h"
+#include "stack_profile.h"
+#include "stage_profile.h"
 #ifdef HAVE_BAGL
 #include "bagl.h"
 #endif
@@ -37,11 +44,148 @@
 /** instruction to send back the public key. */
 #define INS_GET_PUBLIC_KEY 0x04
 
+/** instruction to send back the app version, what the app supports and its size limits, so the
+ * host can choose how to send transactions. */
+#define INS_GET_APP_CONFIGURATION 0x06
+
 /** instruction to send back the public key, and a signature of the private key signing the public
  * key. */
 #define INS_GET_SIGNED_PUBLIC_KEY 0x08
+
+/** instruction to sign a transaction with several keys and send back one signature per key. the
+ * BIP44 paths are appended after the transaction, P2 of the last part gives their number. */
+#define INS_SIGN_MULTI 0x0A
+
+/** instruction to queue transactions, review them all at once and send back their signatures. the
+ * transactions are sent like for INS_SIGN, then P1_BATCH_REVIEW shows the review and
+ * P1_BATCH_SIGNATURE returns the signature of each approved transaction. */
+#define INS_SIGN_BATCH 0x0C
+
+/** instruction to set the spending policy of the session. once the user approves it, the INS_SIGN
+ * transactions within its limits are signed without review. P1_POLICY_CLEAR drops it. */
+#define INS_SET_POLICY 0x0E
+
+/** instruction to choose the format of the signature responses, P1 holds the SIGN_FORMAT_* flags.
+ * the choice lasts until the app exits. */
+#define INS_SET_SIGN_FORMAT 0x10
+
+/** instruction to attest an output of a previous transaction, which is streamed in parts like a
+ * transaction to sign. the attestations loaded with P1_ATTEST_LOAD let the review of the next
+ * transaction show the totals of its inputs and its fee. */
+#define INS_ATTEST_INPUT 0x12
+
+/** instruction to parse a transaction without review or signing, and send back what the review
+ * would show as TLVs. the transaction is sent like for INS_SIGN, then P1_DRY_RUN_OUTPUTS asks for
+ * the outputs that did not fit in the response. */
+#define INS_DRY_RUN 0x14
+
+#ifdef HAVE_STACK_PROFILE
+/** debug builds only, instruction to send back the stack size and the most stack each instruction
+ * used. P1_STACK_PROFILE_RESET clears them once sent. */
+#define INS_GET_STACK_PROFILE 0xE0
+#endif
+
+#ifdef HAVE_STAGE_PROFILE
+/** debug builds only, instruction to send back the counters of the signing stages and clear them.
+ */
+#define INS_GET_STAGE_PROFILE 0xE2
+#endif
+
+/** instruction to exit the app and return to the dashboard. */
+#define INS_EXIT 0xFF
 /** #### instructions end #### */
 
+/** #### capabilities start #### **/
+/** transaction parts can be sent in extended length APDUs. */
+#define CAPABILITY_EXTENDED_APDU 0x0001
+
+/** a transaction can be signed with several keys, INS_SIGN_MULTI. */
+#define CAPABILITY_SIGN_MULTI 0x0002
+
+/** transactions can be queued and reviewed at once, INS_SIGN_BATCH. */
+#define CAPABILITY_SIGN_BATCH 0x0004
+
+/** a spending policy can be set, INS_SET_POLICY. */
+#define CAPABILITY_POLICY 0x0008
+
+/** the signature response format can be chosen, INS_SET_SIGN_FORMAT. */
+#define CAPABILITY_SIGN_FORMAT 0x0010
+
+/** the inputs of a transaction can be attested, INS_ATTEST_INPUT. */
+#define CAPABILITY_ATTEST_INPUT 0x0020
+
+/** the app can be called by the Exchange app. */
+#define CAPABILITY_SWAP 0x0040
+
+/** transaction parts can carry a sequence number and a checksum, P1_SEQUENCED. */
+#define CAPABILITY_SEQUENCED_PARTS 0x0080
+
+/** a transaction can be parsed without review or signing, INS_DRY_RUN. */
+#define CAPABILITY_DRY_RUN 0x0100
+
+/** the first transaction part can give the total length, P1_TOTAL_LENGTH, to show the progress of
+ * the upload. */
+#define CAPABILITY_UPLOAD_PROGRESS 0x0200
+/** #### capabilities end #### */
+
+/** an instruction handler. it writes its response to G_io_apdu_buffer with its length in tx, and
+ * IO_ASYNCH_REPLY to flags when the response is sent later, and returns the status word. */
+typedef unsigned short (*apdu_handler_t)(unsigned int rx, unsigned int *tx, unsigned int *flags);
+
+/** an instruction, with the length its APDUs need at least. */
+typedef struct {
+    /** the instruction code. */
+    unsigned char ins;
+
+    /** the min length of its APDUs. */
+    unsigned char min_rx;
+
+    /** the status word of an APDU shorter than min_rx, or shorter than its body length. */
+    unsigned short short_sw;
+
+    /** true if the instruction drives the signing session, so a malformed APDU ends it. */
+    bool in_session;
+
+    /** the handler of the instruction. */
+    apdu_handler_t handler;
+} apdu_instruction_t;
+
+/** writes the app configuration to G_io_apdu_buffer: <version major> <version minor> <version
+ * patch> <capabilities, 2 bytes> <max transaction part length, 2 bytes> <max transaction length, 2
+ * bytes> <max keys per transaction> <max transactions per batch>. the multi byte values are big
+ * endian. */
+static unsigned short get_app_configuration(unsigned int rx,
+                                            unsigned int *tx,
+                                            unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    unsigned int capabilities = CAPABILITY_EXTENDED_APDU | CAPABILITY_SIGN_MULTI |
+                                CAPABILITY_SIGN_BATCH | CAPABILITY_POLICY |
+                                CAPABILITY_SIGN_FORMAT | CAPABILITY_ATTEST_INPUT |
+                                CAPABILITY_SEQUENCED_PARTS | CAPABILITY_DRY_RUN |
+                                CAPABILITY_UPLOAD_PROGRESS;
+#ifdef HAVE_SWAP
+    capabilities |= CAPABILITY_SWAP;
+#endif
+    // the body of a part is followed by a terminating zero.
+    unsigned int max_part_len = sizeof(G_io_apdu_buffer) - EXTENDED_APDU_HEADER_LENGTH - 1;
+
+    unsigned int len = 0;
+    G_io_apdu_buffer[len++] = APPVERSION_M;
+    G_io_apdu_buffer[len++] = APPVERSION_N;
+    G_io_apdu_buffer[len++] = APPVERSION_P;
+    G_io_apdu_buffer[len++] = capabilities >> 8;
+    G_io_apdu_buffer[len++] = capabilities;
+    G_io_apdu_buffer[len++] = max_part_len >> 8;
+    G_io_apdu_buffer[len++] = max_part_len;
+    G_io_apdu_buffer[len++] = MAX_TX_RAW_LENGTH >> 8;
+    G_io_apdu_buffer[len++] = MAX_TX_RAW_LENGTH & 0xFF;
+    G_io_apdu_buffer[len++] = MAX_SIGN_PATHS;
+    G_io_apdu_buffer[len++] = MAX_BATCH_TXS;
+    *tx = len;
+    return SW_OK;
+}
+
 #if defined(TARGET_NANOS)
 /** refreshes the display if the public key was changed ans we are on the page displaying the public
  * key */
@@ -52,11 +196,522 @@ static void refresh_public_key_display(void) {
 }
 #endif
 
+/** reads the BIP44 path at the start of the APDU body. */
+static void read_bip44_path(unsigned int *bip44_path) {
+    /** BIP44 path, used to derive the private key from the mnemonic by calling
+     * os_perso_derive_node_bip32. */
+    unsigned char *bip44_in = G_io_apdu_buffer + APDU_HEADER_LENGTH;
+    for (uint32_t i = 0; i < BIP44_PATH_LEN; i++) {
+        bip44_path[i] =
+            (bip44_in[0] << 24) | (bip44_in[1] << 16) | (bip44_in[2] << 8) | (bip44_in[3]);
+        bip44_in += 4;
+    }
+}
+
+/** show the progress of the upload on its first part, then every few parts. drawing it for each
+ * part would slow down fast transports. the Exchange app shows its own screens during a swap. */
+static void show_upload_progress(void) {
+#ifdef HAVE_SWAP
+    if (swap.active) {
+        return;
+    }
+#endif
+    if ((session.parts - 1) % PROGRESS_UPDATE_PARTS == 0) {
+        ui_upload_progress();
+    }
+}
+
+/** we're getting a transaction to sign, in parts. the last part is parsed into human readable
+ * text, and reviewed, queued, signed right away or dry run, depending on the instruction. */
+static unsigned short handle_sign_tx(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+    // a sequenced part, or a first part with the total length, is handled like the others once its
+    // headers are read.
+    bool sequenced = (G_io_apdu_buffer[2] & P1_SEQUENCED) != 0;
+    bool total_length = (G_io_apdu_buffer[2] & P1_TOTAL_LENGTH) != 0;
+    G_io_apdu_buffer[2] &= ~(P1_SEQUENCED | P1_TOTAL_LENGTH);
+
+    // check the third byte (0x02) for the instruction subtype.
+    if ((G_io_apdu_buffer[2] != P1_MORE) && (G_io_apdu_buffer[2] != P1_LAST)) {
+        session_end();
+        return 0x6A86;
+    }
+
+    // extended length APDUs carry larger parts, so fewer of them.
+    unsigned int body_offset;
+    unsigned int len;
+    CHECK_SW(get_apdu_body(rx, &body_offset, &len));
+    unsigned char *in = G_io_apdu_buffer + body_offset;
+
+    // sequenced part zero always starts a new transaction.
+    if (sequenced && (len >= SEQUENCED_PART_HEADER_LENGTH) && (in[0] == 0) && (in[1] == 0)) {
+        session_end();
+    }
+
+    // if this is the first transaction part, start a new session. a part can only arrive while
+    // the session receives, the review and the signature hold the reply to the last part.
+    if (session.state != SESSION_RECEIVING) {
+        session_begin();
+    }
+
+    // the total length follows the sequenced part header, the checksum only covers the
+    // transaction.
+    unsigned int header_len = sequenced ? SEQUENCED_PART_HEADER_LENGTH : 0;
+    if (total_length) {
+        header_len += TOTAL_LENGTH_HEADER_LENGTH;
+    }
+
+    // a sequenced part that is not the next one, or that does not match the checksum, is dropped
+    // without ending the upload. the response holds the sequence number of the part expected,
+    // which the host resends from.
+    unsigned short part_crc = session.crc;
+    if (sequenced) {
+        if (len >= header_len) {
+            part_crc = crc16_update(session.crc, in + header_len, len - header_len);
+        }
+        if ((len < header_len) || (((in[0] << 8) | in[1]) != session.seq) ||
+            (((in[2] << 8) | in[3]) != part_crc)) {
+            G_io_apdu_buffer[0] = session.seq >> 8;
+            G_io_apdu_buffer[1] = session.seq;
+            *tx = 2;
+            return 0x6D1F;
+        }
+    }
+
+    // only the first part gives the total length.
+    if (total_length) {
+        if ((raw_tx_ix != 0) || (len < header_len)) {
+            session_end();
+            return 0x6A86;
+        }
+        session.total_len = (in[header_len - 2] << 8) | in[header_len - 1];
+        if (session.total_len > MAX_TX_RAW_LENGTH) {
+            session_end();
+            return 0x6D08;
+        }
+    }
+    in += header_len;
+    len -= header_len;
+
+    // move the contents of the buffer into raw_tx, and update raw_tx_ix to the end of the buffer,
+    // to be ready for the next part of the tx.
+    unsigned char *out = raw_tx + raw_tx_ix;
+    if (raw_tx_ix + len > MAX_TX_RAW_LENGTH) {
+        session_end();
+        return 0x6D08;
+    }
+    memmove(out, in, len);
+    raw_tx_ix += len;
+    if (sequenced) {
+        session.seq++;
+        session.crc = part_crc;
+    }
+    session.parts++;
+
+    // set the screen to be the first screen.
+    curr_scr_ix = 0;
+
+    // set the buffer to end with a zero.
+    in[len] = '\0';
+
+    // if this is the last part of the transaction, parse the transaction into human readable text,
+    // and display it.
+    if (G_io_apdu_buffer[2] == P1_LAST) {
+        raw_tx_len = raw_tx_ix;
+        raw_tx_ix = 0;
+
+        // a dry run only sends back what the review would show.
+        if (G_io_apdu_buffer[1] == INS_DRY_RUN) {
+            session_end();
+            return dry_run_tx(tx);
+        }
+
+        // parse the transaction into human readable text. the parser leaves the session to its
+        // callers, so it ends here.
+        unsigned short sw = display_tx_desc();
+        if (sw != SW_OK) {
+            session_end();
+            return sw;
+        }
+
+        // the loaded attestations are only for this transaction.
+        attest_clear_inputs();
+
+        // queue the transaction, it is reviewed along with the whole batch.
+        if (G_io_apdu_buffer[1] == INS_SIGN_BATCH) {
+            // the transaction is complete once it is queued, or refused.
+            unsigned char batch_ix;
+            session_end();
+            CHECK_SW(batch_add_tx(&batch_ix));
+            G_io_apdu_buffer[0] = batch_ix;
+            *tx = 1;
+            return SW_OK;
+        }
+
+        // derive the signing keys while the user reviews the transaction.
+        if (G_io_apdu_buffer[1] == INS_SIGN_MULTI) {
+            CHECK_SW(prepare_signing_context(G_io_apdu_buffer[3], true));
+        } else {
+            CHECK_SW(prepare_signing_context(1, false));
+        }
+
+#ifdef HAVE_SWAP
+        // the payout of a swap is signed without review, then the app returns to the Exchange app.
+        if (swap.active) {
+            swap_sign_tx_and_exit();
+        }
+#endif
+
+        // a retry of a transaction the user already approved is not reviewed again, and does not
+        // count against the spending policy.
+        if ((G_io_apdu_buffer[1] == INS_SIGN) && sign_tx_from_cache()) {
+            *flags |= IO_ASYNCH_REPLY;
+            return SW_OK;
+        }
+
+        // a transaction within the spending policy is signed without review.
+        if ((G_io_apdu_buffer[1] == INS_SIGN) && policy_consume_tx()) {
+            *flags |= IO_ASYNCH_REPLY;
+            sign_tx_and_send_response();
+            return SW_OK;
+        }
+
+        // display the UI, starting at the top screen which is "Sign Tx Now".
+        session.state = SESSION_REVIEWING;
+        PROFILE_STAGE(STAGE_REVIEW, max_scr_ix);
+        ui_top_sign();
+    }
+
+    *flags |= IO_ASYNCH_REPLY;
+
+    // if this is not the last part of the transaction, do not display the review, and approve the
+    // partial transaction. this adds the TX to the hash.
+    if (G_io_apdu_buffer[2] == P1_MORE) {
+        show_upload_progress();
+        sign_tx_and_send_response();
+    }
+    return SW_OK;
+}
+
+/** we're asked to review or sign the queued transactions, otherwise the transactions are received
+ * like for INS_SIGN. */
+static unsigned short handle_sign_batch(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+    if (G_io_apdu_buffer[2] == P1_BATCH_REVIEW) {
+        if (batch.count == 0) {
+            return 0x6D16;
+        }
+        CHECK_SW(ui_batch_review());
+        *flags |= IO_ASYNCH_REPLY;
+        return SW_OK;
+    }
+    if (G_io_apdu_buffer[2] == P1_BATCH_SIGNATURE) {
+        return batch_sign(G_io_apdu_buffer[3], tx);
+    }
+    return handle_sign_tx(rx, tx, flags);
+}
+
+/** we're asked for more of the outputs of a dry run, otherwise the transaction is received like
+ * for INS_SIGN. */
+static unsigned short handle_dry_run(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+    if (G_io_apdu_buffer[2] == P1_DRY_RUN_OUTPUTS) {
+        return dry_run_outputs(G_io_apdu_buffer[3], tx);
+    }
+    return handle_sign_tx(rx, tx, flags);
+}
+
+/** we're asked to set or drop the spending policy. */
+static unsigned short handle_set_policy(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(tx);
+    session_end();
+    if (G_io_apdu_buffer[2] == P1_POLICY_CLEAR) {
+        policy_clear();
+        return SW_OK;
+    }
+    if (G_io_apdu_buffer[2] != P1_POLICY_SET) {
+        return 0x6A86;
+    }
+
+    CHECK_SW(policy_set(G_io_apdu_buffer + APDU_HEADER_LENGTH, get_apdu_buffer_length()));
+    CHECK_SW(ui_policy_review());
+    *flags |= IO_ASYNCH_REPLY;
+    return SW_OK;
+}
+
+/** we're asked for the public key. */
+static unsigned short handle_get_public_key(unsigned int rx,
+                                            unsigned int *tx,
+                                            unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    uint8_t raw_pubkey[65];
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    read_bip44_path(bip44_path);
+
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    if (bip32_derive_get_pubkey_256(CX_CURVE_256R1,
+                                    bip44_path,
+                                    BIP44_PATH_LEN,
+                                    raw_pubkey,
+                                    NULL,
+                                    CX_SHA512) != CX_OK) {
+        return 0x6D00;
+    }
+
+    // push the public key onto the response buffer.
+    memmove(G_io_apdu_buffer, raw_pubkey, sizeof(raw_pubkey));
+
+    CHECK_SW(display_public_key(raw_pubkey));
+#if defined(TARGET_NANOS)
+    refresh_public_key_display();
+#endif
+    *tx = sizeof(raw_pubkey);
+    return SW_OK;
+}
+
+/** we're asking for the signed public key. */
+static unsigned short handle_get_signed_public_key(unsigned int rx,
+                                                   unsigned int *tx,
+                                                   unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    cx_ecfp_public_key_t publicKey;
+    cx_ecfp_private_key_t privateKey;
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    read_bip44_path(bip44_path);
+
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    if (bip32_derive_init_privkey_256(CX_CURVE_256R1,
+                                      bip44_path,
+                                      BIP44_PATH_LEN,
+                                      &privateKey,
+                                      NULL) != CX_OK) {
+        return 0x6D00;
+    }
+
+    // generate the public key, and sign its hash. the signature follows the public key and 0xFFFF.
+    unsigned char result[32];
+    unsigned int sig_offset = sizeof(publicKey.W) + 2;
+    size_t sig_len = sizeof(G_io_apdu_buffer) - sig_offset - 2;
+
+    cx_err_t error = cx_ecdsa_init_public_key(CX_CURVE_256R1, NULL, 0, &publicKey);
+    if (error == CX_OK) {
+        error = cx_ecfp_generate_pair_no_throw(CX_CURVE_256R1, &publicKey, &privateKey, 1);
+    }
+    if (error == CX_OK) {
+        cx_hash_sha256(publicKey.W, 65, result, sizeof(result));
+    }
+    if (error == CX_OK) {
+        PROFILE_STAGE(STAGE_SIGN, sizeof(result));
+        error = cx_ecdsa_sign_no_throw((void *) &privateKey,
+                                       CX_RND_RFC6979 | CX_LAST,
+                                       CX_SHA256,
+                                       result,
+                                       sizeof(result),
+                                       G_io_apdu_buffer + sig_offset,
+                                       &sig_len,
+                                       NULL);
+    }
+    explicit_bzero(&privateKey, sizeof(privateKey));
+    if (error != CX_OK) {
+        return 0x6D00;
+    }
+
+    // push the public key onto the response buffer.
+    memmove(G_io_apdu_buffer, publicKey.W, 65);
+    G_io_apdu_buffer[65] = 0xFF;
+    G_io_apdu_buffer[66] = 0xFF;
+
+    CHECK_SW(display_public_key(publicKey.W));
+#if defined(TARGET_NANOS)
+    refresh_public_key_display();
+#endif
+    *tx = sig_offset + sig_len;
+    return SW_OK;
+}
+
+/** we're streamed a previous transaction, or given back its attestation. */
+static unsigned short handle_attest_input(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    unsigned char *in = G_io_apdu_buffer + APDU_HEADER_LENGTH;
+    unsigned int len = get_apdu_buffer_length();
+    switch (G_io_apdu_buffer[2]) {
+        case P1_ATTEST_STREAM_MORE:
+        case P1_ATTEST_STREAM_LAST:
+            CHECK_SW(attest_stream(in, len, G_io_apdu_buffer[3] == P2_ATTEST_FIRST));
+            if (G_io_apdu_buffer[2] == P1_ATTEST_STREAM_LAST) {
+                return attest_stream_finish(G_io_apdu_buffer, tx);
+            }
+            return SW_OK;
+        case P1_ATTEST_LOAD:
+            return attest_load(in, len);
+        case P1_ATTEST_CLEAR:
+            attest_clear_inputs();
+            return SW_OK;
+        default:
+            return 0x6A86;
+    }
+}
+
+/** we're asked to change the format of the signature responses. */
+static unsigned short handle_set_sign_format(unsigned int rx,
+                                             unsigned int *tx,
+                                             unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(tx);
+    UNUSED(flags);
+    if ((G_io_apdu_buffer[2] & ~SIGN_FORMAT_ALL) != 0) {
+        return 0x6A86;
+    }
+    sign_format = G_io_apdu_buffer[2];
+    return SW_OK;
+}
+
+#ifdef HAVE_STACK_PROFILE
+static unsigned short handle_get_stack_profile(unsigned int rx,
+                                               unsigned int *tx,
+                                               unsigned int *flags);
+#endif
+
+#ifdef HAVE_STAGE_PROFILE
+/** writes the stage counters to G_io_apdu_buffer and clears them: for each stage <stage> <calls, 4
+ * bytes> <bytes worked on, 4 bytes>. the counters are big endian. */
+static unsigned short handle_get_stage_profile(unsigned int rx,
+                                               unsigned int *tx,
+                                               unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    unsigned int len = 0;
+    for (unsigned char stage = 0; stage < STAGE_PROFILE_STAGES; stage++) {
+        G_io_apdu_buffer[len++] = stage;
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            G_io_apdu_buffer[len++] = stage_counters[stage].calls >> shift;
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            G_io_apdu_buffer[len++] = stage_counters[stage].bytes >> shift;
+        }
+    }
+    memset(stage_counters, 0, sizeof(stage_counters));
+    *tx = len;
+    return SW_OK;
+}
+#endif
+
+/** the instructions, and the length of their APDUs. the ones that read a BIP44 path need it all.
+ * the instructions that only read, like the public keys, can come in the middle of an upload. */
+static const apdu_instruction_t apdu_instructions[] = {
+    {INS_SIGN, APDU_HEADER_LENGTH, 0x6D21, true, handle_sign_tx},
+    {INS_GET_PUBLIC_KEY,
+     APDU_HEADER_LENGTH + BIP44_BYTE_LENGTH,
+     0x6D09,
+     false,
+     handle_get_public_key},
+    {INS_GET_APP_CONFIGURATION, APDU_HEADER_LENGTH, 0x6D21, false, get_app_configuration},
+    {INS_GET_SIGNED_PUBLIC_KEY,
+     APDU_HEADER_LENGTH + BIP44_BYTE_LENGTH,
+     0x6D10,
+     false,
+     handle_get_signed_public_key},
+    {INS_SIGN_MULTI, APDU_HEADER_LENGTH, 0x6D21, true, handle_sign_tx},
+    {INS_SIGN_BATCH, APDU_HEADER_LENGTH, 0x6D21, true, handle_sign_batch},
+    {INS_SET_POLICY, APDU_HEADER_LENGTH, 0x6D21, true, handle_set_policy},
+    {INS_SET_SIGN_FORMAT, APDU_HEADER_LENGTH, 0x6D21, false, handle_set_sign_format},
+    {INS_ATTEST_INPUT, APDU_HEADER_LENGTH, 0x6D21, false, handle_attest_input},
+    {INS_DRY_RUN, APDU_HEADER_LENGTH, 0x6D21, true, handle_dry_run},
+#ifdef HAVE_STACK_PROFILE
+    {INS_GET_STACK_PROFILE, APDU_HEADER_LENGTH, 0x6D21, false, handle_get_stack_profile},
+#endif
+#ifdef HAVE_STAGE_PROFILE
+    {INS_GET_STAGE_PROFILE, APDU_HEADER_LENGTH, 0x6D21, false, handle_get_stage_profile},
+#endif
+};
+
+#ifdef HAVE_STACK_PROFILE
+/** writes the stack profile to G_io_apdu_buffer: <stack size, 2 bytes> then for each instruction
+ * <instruction> <most stack used, 2 bytes>. the sizes are big endian, in bytes. */
+static unsigned short handle_get_stack_profile(unsigned int rx,
+                                               unsigned int *tx,
+                                               unsigned int *flags) {
+    UNUSED(rx);
+    UNUSED(flags);
+    unsigned short stack_size = stack_profile_size();
+    G_io_apdu_buffer[0] = stack_size >> 8;
+    G_io_apdu_buffer[1] = stack_size & 0xFF;
+    *tx = 2;
+    for (unsigned int ins_ix = 0;
+         (ins_ix < sizeof(apdu_instructions) / sizeof(apdu_instructions[0])) &&
+         (ins_ix < STACK_PROFILE_SLOTS);
+         ins_ix++) {
+        G_io_apdu_buffer[(*tx)++] = apdu_instructions[ins_ix].ins;
+        G_io_apdu_buffer[(*tx)++] = stack_peak[ins_ix] >> 8;
+        G_io_apdu_buffer[(*tx)++] = stack_peak[ins_ix] & 0xFF;
+    }
+    if (G_io_apdu_buffer[2] == P1_STACK_PROFILE_RESET) {
+        stack_profile_reset();
+    }
+    return SW_OK;
+}
+#endif
+
+/** check the rx bytes APDU in G_io_apdu_buffer and run the handler of its instruction. returns the
+ * status word. */
+static unsigned short dispatch_apdu(unsigned int rx, unsigned int *tx, unsigned int *flags) {
+#ifdef HAVE_STACK_PROFILE
+    // the previous instruction ran until this APDU arrived.
+    stack_profile_end();
+#endif
+
+    // no apdu received, well, reset the session, and reset the bootloader configuration
+    if (rx == 0) {
+        session_end();
+        return 0x6982;
+    }
+
+    // if the buffer doesn't start with the magic byte, return an error.
+    if (G_io_apdu_buffer[0] != CLA) {
+        return 0x6E00;
+    }
+
+#ifdef HAVE_SWAP
+    // while the Exchange app runs the app, only what the payout needs is allowed.
+    if (swap.active && (G_io_apdu_buffer[1] != INS_SIGN) &&
+        (G_io_apdu_buffer[1] != INS_GET_PUBLIC_KEY) &&
+        (G_io_apdu_buffer[1] != INS_GET_APP_CONFIGURATION) &&
+        (G_io_apdu_buffer[1] != INS_ATTEST_INPUT)) {
+        return 0x6D1D;
+    }
+#endif
+
+    // check the second byte (0x01) for the instruction.
+    for (unsigned int ins_ix = 0; ins_ix < sizeof(apdu_instructions) / sizeof(apdu_instructions[0]);
+         ins_ix++) {
+        const apdu_instruction_t *instruction = &apdu_instructions[ins_ix];
+        if (instruction->ins != G_io_apdu_buffer[1]) {
+            continue;
+        }
+        // a short APDU must hold all of the body its length byte gives.
+        if ((rx < instruction->min_rx) ||
+            (rx < APDU_HEADER_LENGTH + G_io_apdu_buffer[APDU_BODY_LENGTH_OFFSET])) {
+            if (instruction->in_session) {
+                session_end();
+            }
+            return instruction->short_sw;
+        }
+#ifdef HAVE_STACK_PROFILE
+        stack_profile_begin(ins_ix);
+#endif
+        return instruction->handler(rx, tx, flags);
+    }
+
+    // we're asked to do an unknown command
+    return 0x6D00;
+}
+
 /** main loop. */
 static void neo_main(void) {
-    volatile unsigned int rx = 0;
-    volatile unsigned int tx = 0;
-    volatile unsigned int flags = 0;
+    unsigned int rx = 0;
+    unsigned int tx = 0;
+    unsigned int flags = 0;
 
     // DESIGN NOTE: the bootloader ignores the way APDU are fetched. The only
     // goal is to retrieve APDU.
@@ -65,285 +720,117 @@ static void neo_main(void) {
     // switch event, before the apdu is replied to the bootloader. This avoid
     // APDU injection faults.
     for (;;) {
-        volatile unsigned short sw = 0;
+        rx = io_exchange(CHANNEL_APDU | flags, tx);
+        tx = 0;
+        flags = 0;
 
+        // return to dashboard.
+        if ((rx >= 2) && (G_io_apdu_buffer[0] == CLA) && (G_io_apdu_buffer[1] == INS_EXIT)) {
+            return;
+        }
+
+        volatile unsigned short sw = 0;
+        volatile bool io_reset = false;
         BEGIN_TRY {
             TRY {
-                rx = tx;
-                // ensure no race in catch_other if io_exchange throws an error
-                tx = 0;
-                rx = io_exchange(CHANNEL_APDU | flags, rx);
-                flags = 0;
-
-                // no apdu received, well, reset the session, and reset the
-                // bootloader configuration
-                if (rx == 0) {
-                    hashTainted = 1;
-                    THROW(0x6982);
-                }
-
-                // if the buffer doesn't start with the magic byte, return an error.
-                if (G_io_apdu_buffer[0] != CLA) {
-                    hashTainted = 1;
-                    THROW(0x6E00);
-                }
-
-                // check the second byte (0x01) for the instruction.
-                switch (G_io_apdu_buffer[1]) {
-                    // we're getting a transaction to sign, in parts.
-                    case INS_SIGN: {
-                        // check the third byte (0x02) for the instruction subtype.
-                        if ((G_io_apdu_buffer[2] != P1_MORE) && (G_io_apdu_buffer[2] != P1_LAST)) {
-                            hashTainted = 1;
-                            THROW(0x6A86);
-                        }
-
-                        // if this is the first transaction part, reset the hash and all the other
-                        // temporary variables.
-                        if (hashTainted) {
-                            cx_sha256_init(&tx_hash);
-                            hashTainted = 0;
-                            raw_tx_ix = 0;
-                            raw_tx_len = 0;
-                        }
-
-                        // move the contents of the buffer into raw_tx, and update raw_tx_ix to the
-                        // end of the buffer, to be ready for the next part of the tx.
-                        unsigned int len = get_apdu_buffer_length();
-                        unsigned char *in = G_io_apdu_buffer + APDU_HEADER_LENGTH;
-                        unsigned char *out = raw_tx + raw_tx_ix;
-                        if (raw_tx_ix + len > MAX_TX_RAW_LENGTH) {
-                            hashTainted = 1;
-                            THROW(0x6D08);
-                        }
-                        memmove(out, in, len);
-                        raw_tx_ix += len;
-
-                        // set the screen to be the first screen.
-                        curr_scr_ix = 0;
-
-                        // set the buffer to end with a zero.
-                        G_io_apdu_buffer[APDU_HEADER_LENGTH + len] = '\0';
-
-                        // if this is the last part of the transaction, parse the transaction into
-                        // human readable text, and display it.
-                        if (G_io_apdu_buffer[2] == P1_LAST) {
-                            raw_tx_len = raw_tx_ix;
-                            raw_tx_ix = 0;
-
-                            // parse the transaction into human readable text.
-                            display_tx_desc();
-
-                            // display the UI, starting at the top screen which is "Sign Tx Now".
-                            ui_top_sign();
-                        }
-
-                        flags |= IO_ASYNCH_REPLY;
-
-                        // if this is not the last part of the transaction, do not display the UI,
-                        // and approve the partial transaction. this adds the TX to the hash.
-                        if (G_io_apdu_buffer[2] == P1_MORE) {
-                            sign_tx_and_send_response();
-                        }
-                    } break;
-
-                        // we're asked for the public key.
-                    case INS_GET_PUBLIC_KEY: {
-                        uint8_t raw_pubkey[65];
-
-                        if (rx < APDU_HEADER_LENGTH + BIP44_BYTE_LENGTH) {
-                            hashTainted = 1;
-                            THROW(0x6D09);
-                        }
-
-                        /** BIP44 path, used to derive the private key from the mnemonic by calling
-                         * os_perso_derive_node_bip32. */
-                        unsigned char *bip44_in = G_io_apdu_buffer + APDU_HEADER_LENGTH;
-
-                        unsigned int bip44_path[BIP44_PATH_LEN];
-                        uint32_t i;
-                        for (i = 0; i < BIP44_PATH_LEN; i++) {
-                            bip44_path[i] = (bip44_in[0] << 24) | (bip44_in[1] << 16) |
-                                            (bip44_in[2] << 8) | (bip44_in[3]);
-                            bip44_in += 4;
-                        }
-
-                        if (bip32_derive_get_pubkey_256(CX_CURVE_256R1,
-                                                        bip44_path,
-                                                        BIP44_PATH_LEN,
-                                                        raw_pubkey,
-                                                        NULL,
-                                                        CX_SHA512) != CX_OK) {
-                            THROW(0x6D00);
-                        }
-
-                        // push the public key onto the response buffer.
-                        memmove(G_io_apdu_buffer, raw_pubkey, sizeof(raw_pubkey));
-                        tx = sizeof(raw_pubkey);
-
-                        display_public_key(raw_pubkey);
-#if defined(TARGET_NANOS)
-                        refresh_public_key_display();
-#endif
-                        // return 0x9000 OK.
-                        THROW(0x9000);
-                    } break;
-
-                        // we're asking for the signed public key.
-                    case INS_GET_SIGNED_PUBLIC_KEY: {
-                        cx_ecfp_public_key_t publicKey;
-                        cx_ecfp_private_key_t privateKey;
-
-                        if (rx < APDU_HEADER_LENGTH + BIP44_BYTE_LENGTH) {
-                            hashTainted = 1;
-                            THROW(0x6D10);
-                        }
-
-                        /** BIP44 path, used to derive the private key from the mnemonic by calling
-                         * os_perso_derive_node_bip32. */
-                        unsigned char *bip44_in = G_io_apdu_buffer + APDU_HEADER_LENGTH;
-
-                        unsigned int bip44_path[BIP44_PATH_LEN];
-                        uint32_t i;
-                        for (i = 0; i < BIP44_PATH_LEN; i++) {
-                            bip44_path[i] = (bip44_in[0] << 24) | (bip44_in[1] << 16) |
-                                            (bip44_in[2] << 8) | (bip44_in[3]);
-                            bip44_in += 4;
-                        }
-
-                        if (bip32_derive_init_privkey_256(CX_CURVE_256R1,
-                                                          bip44_path,
-                                                          BIP44_PATH_LEN,
-                                                          &privateKey,
-                                                          NULL) != CX_OK) {
-                            THROW(0x6D00);
-                        }
-
-                        // generate the public key.
-                        CX_ASSERT(cx_ecdsa_init_public_key(CX_CURVE_256R1, NULL, 0, &publicKey));
-                        CX_ASSERT(cx_ecfp_generate_pair_no_throw(CX_CURVE_256R1,
-                                                                 &publicKey,
-                                                                 &privateKey,
-                                                                 1));
-
-                        // push the public key onto the response buffer.
-                        memmove(G_io_apdu_buffer, publicKey.W, 65);
-                        tx = 65;
-
-                        display_public_key(publicKey.W);
-#if defined(TARGET_NANOS)
-                        refresh_public_key_display();
-#endif
-                        G_io_apdu_buffer[tx++] = 0xFF;
-                        G_io_apdu_buffer[tx++] = 0xFF;
-
-                        unsigned char result[32];
-
-                        cx_sha256_t pubKeyHash;
-                        cx_sha256_init(&pubKeyHash);
-
-                        CX_ASSERT(cx_hash_no_throw(&pubKeyHash.header,
-                                                   CX_LAST,
-                                                   publicKey.W,
-                                                   65,
-                                                   result,
-                                                   32));
-                        size_t sig_len = sizeof(G_io_apdu_buffer) - tx;
-
-                        if (cx_ecdsa_sign_no_throw((void *) &privateKey,
-                                                   CX_RND_RFC6979 | CX_LAST,
-                                                   CX_SHA256,
-                                                   result,
-                                                   sizeof(result),
-                                                   G_io_apdu_buffer + tx,
-                                                   &sig_len,
-                                                   NULL) != CX_OK) {
-                            THROW(0x6D00);
-                        }
-
-                        tx += sig_len;
-
-                        // return 0x9000 OK.
-                        THROW(0x9000);
-                    } break;
-
-                    case 0xFF:  // return to dashboard
-                        goto return_to_dashboard;
-
-                        // we're asked to do an unknown command
-                    default:
-                        // return an error.
-                        hashTainted = 1;
-                        THROW(0x6D00);
-                        break;
-                }
+                sw = dispatch_apdu(rx, &tx, &flags);
+            }
+            CATCH(EXCEPTION_IO_RESET) {
+                io_reset = true;
             }
             CATCH_OTHER(e) {
-                switch (e & 0xF000) {
-                    case 0x6000:
-                    case 0x9000:
-                        sw = e;
-                        break;
-                    default:
-                        sw = 0x6800 | (e & 0x7FF);
-                        break;
-                }
-                // Unexpected exception => report
-                G_io_apdu_buffer[tx] = sw >> 8;
-                G_io_apdu_buffer[tx + 1] = sw;
-                tx += 2;
+                // a throw of the OS or the crypto library ends the instruction, not the app. its
+                // response and session are dropped.
+                session_end();
+                tx = 0;
+                flags = 0;
+                sw = 0x6800 | (e & 0x7FF);
             }
             FINALLY {
             }
         }
         END_TRY;
-    }
+        // the reset of the IO starts the app over, see main.
+        if (io_reset) {
+            THROW(EXCEPTION_IO_RESET);
+        }
 
-return_to_dashboard:
-    return;
+        // the handlers that answer later send their own status word.
+        if ((flags & IO_ASYNCH_REPLY) == 0) {
+            tx = append_status_word(tx, sw);
+        } else {
+            tx = 0;
+        }
+    }
 }
 
-/** boot up the app and intialize it */
-__attribute__((section(".boot"))) int main(void) {
+/** boot up the app and intialize it. arg0 is zero when the app is started from the dashboard,
+ * otherwise it is called by the Exchange app. */
+__attribute__((section(".boot"))) int main(int arg0) {
     // exit critical section
     __asm volatile("cpsie i");
 
     curr_scr_ix = 0;
     max_scr_ix = 0;
     raw_tx_ix = 0;
-    hashTainted = 1;
+    session_end();
     uiState = UI_IDLE;
 
     // ensure exception will work as planned
     os_boot();
 
-    UX_INIT();
+#ifdef HAVE_SWAP
+    // the Exchange app's calls return right away, except the payout which needs the app running.
+    if ((arg0 != 0) && !swap_library_main((libargs_t *) arg0)) {
+        os_lib_end();
+    }
+#else
+    UNUSED(arg0);
+#endif
 
-    BEGIN_TRY {
-        TRY {
-            io_seproxyhal_init();
+    // the instructions return their errors, neo_main answers what the OS or the crypto library
+    // throws. a reset of the IO starts the app over, anything else exits it.
+    for (;;) {
+        UX_INIT();
+
+        BEGIN_TRY {
+            TRY {
+                io_seproxyhal_init();
 
 #ifdef HAVE_BLE
-            BLE_power(0, NULL);
-            BLE_power(1, NULL);
+                BLE_power(0, NULL);
+                BLE_power(1, NULL);
 #endif
 
-            USB_power(0);
-            USB_power(1);
+                USB_power(0);
+                USB_power(1);
 
-            // init the public key display to "no public key".
-            display_no_public_key();
+                // init the public key display to "no public key".
+                display_no_public_key();
 
-            // show idle screen.
-            ui_idle();
+                // show idle screen.
+                ui_idle();
 
-            // run main event loop.
-            neo_main();
-        }
-        CATCH_OTHER(e) {
-        }
-        FINALLY {
+                // run main event loop.
+                neo_main();
+            }
+            CATCH(EXCEPTION_IO_RESET) {
+                CLOSE_TRY;
+                continue;
+            }
+            CATCH_ALL {
+            }
+            FINALLY {
+            }
         }
+        END_TRY;
+        break;
     }
-    END_TRY;
+
+#ifdef HAVE_SWAP
+    // the app was left before the payout was signed.
+    if (swap.active) {
+        os_lib_end();
+    }
+#endif
 }
@@ -2,6 +2,8 @@
  * MIT License, see root folder for full license.
  */
 #include "neo.h"
+#include "attest.h"
+#include "stage_profile.h"
 
 /** if true, show a screen with the transaction type. */
 #define SHOW_TX_TYPE true
@@ -30,28 +32,9 @@
 /** if true, show script hash screen as well as address screen */
 #define SHOW_SCRIPT_HASH false
 
-/**
- * each CoinReference has two fields:
- *  UInt256 PrevHash = 32 bytes.
- *  ushort PrevIndex = 2 bytes.
- */
-#define COIN_REFERENCES_LEN (32 + 2)
-
-/** length of tx.output.value */
-#define VALUE_LEN 8
-
-/** length of tx.output.asset_id */
-#define ASSET_ID_LEN 32
-
-/** length of tx.output.script_hash */
-#define SCRIPT_HASH_LEN 20
-
 /** length of the checksum used to convert a tx.output.script_hash into an Address. */
 #define SCRIPT_HASH_CHECKSUM_LEN 4
 
-/** length of a tx.output Address, after Base58 encoding. */
-#define ADDRESS_BASE58_LEN 34
-
 /** length of a tx.output Address before encoding, which is the length of
  * <address_version>+<script_hash>+<checksum> */
 #define ADDRESS_LEN (1 + SCRIPT_HASH_LEN + SCRIPT_HASH_CHECKSUM_LEN)
@@ -65,75 +48,8 @@
 /** the position of the decimal point, 8 characters in from the right side */
 #define DECIMAL_PLACE_OFFSET 8
 
-/**
- * transaction types.
- *
- * Currently only Claim and Contract are tested, as they are the only ones supported by the current
- * wallets.
- */
-enum TX_TYPE {
-    TX_MINER = 0x00,
-    TX_ISSUE = 0x01,
-    TX_CLAIM = 0x02,
-    TX_ENROLL = 0x20,
-    TX_REGISTER = 0x40,
-    TX_CONTRACT = 0x80,
-    TX_PUBLISH = 0xD0,
-    TX_INVOKE = 0xD1
-};
-
-/**
- * transaction attributes.
- *
- * currently there's no support in wallets for adding attributes to a contract, but the types are as
- * listed below.
- */
-enum TransactionAttributeUsage {
-    CONTRACT_HASH = 0x00,
-
-    ECDH02 = 0x02,
-    ECDH03 = 0x03,
-
-    SCRIPT = 0x20,
-
-    VOTE = 0x30,
-
-    DESCRIPTION_URL = 0x81,
-    DESCRIPTION = 0x90,
-
-    HASH1 = 0xa1,
-    HASH2 = 0xa2,
-    HASH3 = 0xa3,
-    HASH4 = 0xa4,
-    HASH5 = 0xa5,
-    HASH6 = 0xa6,
-    HASH7 = 0xa7,
-    HASH8 = 0xa8,
-    HASH9 = 0xa9,
-    HASH10 = 0xaa,
-    HASH11 = 0xab,
-    HASH12 = 0xac,
-    HASH13 = 0xad,
-    HASH14 = 0xae,
-    HASH15 = 0xaf,
-
-    REMARK = 0xf0,
-    REMARK1 = 0xf1,
-    REMARK2 = 0xf2,
-    REMARK3 = 0xf3,
-    REMARK4 = 0xf4,
-    REMARK5 = 0xf5,
-    REMARK6 = 0xf6,
-    REMARK7 = 0xf7,
-    REMARK8 = 0xf8,
-    REMARK9 = 0xf9,
-    REMARK10 = 0xfa,
-    REMARK11 = 0xfb,
-    REMARK12 = 0xfc,
-    REMARK13 = 0xfd,
-    REMARK14 = 0xfe,
-    REMARK15 = 0xff
-};
+/** summary of the last transaction parsed by display_tx_desc. */
+tx_summary_t tx_summary;
 
 /** MAX_TX_TEXT_WIDTH in blanks, used for clearing a line of text */
 static const char TXT_BLANK[] = "                 ";
@@ -163,6 +79,15 @@ static const char TXT_ASSET_UNKNOWN[] = "UNKNOWN";
 /** text to display if an asset's base-10 encoded value is too low to display */
 static const char TXT_LOW_VALUE[] = "Low Value";
 
+/** text to display in a batch review for a transaction without outputs */
+static const char TXT_NO_OUTPUT[] = "No Output";
+
+/** text to display for the totals of the inputs. */
+static const char TXT_INPUTS[] = "Inputs";
+
+/** text to display for the fee. */
+static const char TXT_FEE[] = "Fee";
+
 /** a period, for displaying the decimal point. */
 static const char TXT_PERIOD[] = ".";
 
@@ -244,19 +169,19 @@ static const char BASE_58_ALPHABET[] = {'1', '2', '3', '4', '5', '6', '7', '8',
 static const char BASE_10_ALPHABET[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
 
 /** skips the given number of bytes in the transaction */
-static void skip_raw_tx(const unsigned int tx_skip);
+static unsigned short skip_raw_tx(const unsigned int tx_skip);
 
-/** returns the number of bytes in the next variable byte record, called prior to reading a variable
- * byte record to know how many bytes to read. */
-static unsigned char next_raw_tx_varbytes_num();
+/** reads the number of bytes in the next variable byte record into num, called prior to reading a
+ * variable byte record to know how many bytes to read. */
+static unsigned short next_raw_tx_varbytes_num(unsigned char *num);
 
 /** reads a set of bytes into the array pointed to by the arr parameter, reads as many bytes as the
  * length parameter specifies. */
-static void next_raw_tx_arr(unsigned char *arr, const unsigned int length);
+static unsigned short next_raw_tx_arr(unsigned char *arr, const unsigned int length);
 
-/** reads the next byte out of the transaction, or throws an error if there are no more bytes left.
- */
-static unsigned char next_raw_tx();
+/** reads the next byte out of the transaction into out, or returns an error if there are no more
+ * bytes left. */
+static unsigned short next_raw_tx(unsigned char *out);
 
 /** returns the minimum of i0 and i1 */
 static unsigned int min(const unsigned int i0, const unsigned int i1);
@@ -266,62 +191,74 @@ static unsigned int min(const unsigned int i0, const unsigned int i1);
 static void to_hex(char *dest, const unsigned char *src, const unsigned int dest_len);
 
 /** encodes in_length bytes from in into the given base, using the given alphabet. writes the
- * converted bytes to out, stopping when it converts out_length bytes. */
-static unsigned int encode_base_x(const char *alphabet,
-                                  const unsigned int alphabet_len,
-                                  const void *in,
-                                  const unsigned int in_length,
-                                  char *out,
-                                  const unsigned int out_length);
-
-/** encodes in_length bytes from in into base-10, writes the converted bytes to out, stopping when
- * it converts out_length bytes.  */
-static unsigned int encode_base_10(const void *in,
-                                   const unsigned int in_length,
-                                   char *out,
-                                   const unsigned int out_length) {
+ * converted bytes to out, at most out_length of them, and their number to encoded_length. */
+static unsigned short encode_base_x(const char *alphabet,
+                                    const unsigned int alphabet_len,
+                                    const void *in,
+                                    const unsigned int in_length,
+                                    char *out,
+                                    const unsigned int out_length,
+                                    unsigned int *encoded_length);
+
+/** encodes in_length bytes from in into base-10, writes the converted bytes to out, at most
+ * out_length of them, and their number to encoded_length. */
+static unsigned short encode_base_10(const void *in,
+                                     const unsigned int in_length,
+                                     char *out,
+                                     const unsigned int out_length,
+                                     unsigned int *encoded_length) {
     return encode_base_x(BASE_10_ALPHABET,
                          sizeof(BASE_10_ALPHABET),
                          in,
                          in_length,
                          out,
-                         out_length);
+                         out_length,
+                         encoded_length);
 }
 
-/** encodes in_length bytes from in into base-58, writes the converted bytes to out, stopping when
- * it converts out_length bytes.  */
-static unsigned int encode_base_58(const void *in,
-                                   const unsigned int in_len,
-                                   char *out,
-                                   const unsigned int out_len) {
-    return encode_base_x(BASE_58_ALPHABET, sizeof(BASE_58_ALPHABET), in, in_len, out, out_len);
+/** encodes in_length bytes from in into base-58, writes the converted bytes to out, at most
+ * out_length of them, and their number to encoded_length. */
+static unsigned short encode_base_58(const void *in,
+                                     const unsigned int in_len,
+                                     char *out,
+                                     const unsigned int out_len,
+                                     unsigned int *encoded_len) {
+    return encode_base_x(BASE_58_ALPHABET,
+                         sizeof(BASE_58_ALPHABET),
+                         in,
+                         in_len,
+                         out,
+                         out_len,
+                         encoded_len);
 }
 
 /** encodes in_length bytes from in into the given base, using the given alphabet. writes the
- * converted bytes to out, stopping when it converts out_length bytes. */
-static unsigned int encode_base_x(const char *alphabet,
-                                  const unsigned int alphabet_len,
-                                  const void *in,
-                                  const unsigned int in_length,
-                                  char *out,
-                                  const unsigned int out_length) {
+ * converted bytes to out, at most out_length of them, and their number to encoded_length. */
+static unsigned short encode_base_x(const char *alphabet,
+                                    const unsigned int alphabet_len,
+                                    const void *in,
+                                    const unsigned int in_length,
+                                    char *out,
+                                    const unsigned int out_length,
+                                    unsigned int *encoded_length) {
     char tmp[64];
     char buffer[128];
-    unsigned char buffer_ix;
+    unsigned int buffer_ix;
     unsigned char startAt;
     unsigned char zeroCount = 0;
     if (in_length > sizeof(tmp)) {
-        hashTainted = 1;
-        THROW(0x6D11);
+        return 0x6D11;
     }
+    PROFILE_STAGE(STAGE_BASE_X, in_length);
     memmove(tmp, in, in_length);
     while ((zeroCount < in_length) && (tmp[zeroCount] == 0)) {
         ++zeroCount;
     }
-    buffer_ix = 2 * in_length;
+    // a byte takes at most 3 digits in a base of 7 or more, 2.41 of them in base 10.
+    const unsigned int buffer_end = 3 * in_length;
+    buffer_ix = buffer_end;
     if (buffer_ix > sizeof(buffer)) {
-        hashTainted = 1;
-        THROW(0x6D12);
+        return 0x6D12;
     }
 
     startAt = zeroCount;
@@ -339,24 +276,28 @@ static unsigned int encode_base_x(const char *alphabet,
         }
         buffer[--buffer_ix] = *(alphabet + remainder);
     }
-    while ((buffer_ix < (2 * in_length)) && (buffer[buffer_ix] == *(alphabet + 0))) {
+    while ((buffer_ix < buffer_end) && (buffer[buffer_ix] == *(alphabet + 0))) {
         ++buffer_ix;
     }
     while (zeroCount-- > 0) {
         buffer[--buffer_ix] = *(alphabet + 0);
     }
-    const unsigned int true_out_length = (2 * in_length) - buffer_ix;
+    const unsigned int true_out_length = buffer_end - buffer_ix;
     if (true_out_length > out_length) {
-        THROW(0x6D14);
+        return 0x6D14;
     }
     memmove(out, (buffer + buffer_ix), true_out_length);
-    return true_out_length;
+    *encoded_length = true_out_length;
+    return SW_OK;
 }
 
 /** converts a value to base10 with a decimal point at DECIMAL_PLACE_OFFSET, which should be
- * 100,000,000 or 100 million, thus the suffix 100m */
-static void to_base10_100m(char *dest, const unsigned char *value, const unsigned int dest_len) {
-    UNUSED(dest_len);
+ * 100,000,000 or 100 million, thus the suffix 100m. the text and its terminating null must fit in
+ * dest_len. */
+unsigned short to_base10_100m(char *dest, const unsigned char *value, const unsigned int dest_len) {
+    if (dest_len < sizeof(TXT_LOW_VALUE)) {
+        return 0x6D14;
+    }
     // reverse the array
     unsigned char reverse_value[VALUE_LEN];
     for (int ix = 0; ix < VALUE_LEN; ix++) {
@@ -364,9 +305,14 @@ static void to_base10_100m(char *dest, const unsigned char *value, const unsigne
     }
 
     // encode in base10
-    char base10_buffer[MAX_TX_TEXT_WIDTH];
-    unsigned int buffer_len =
-        encode_base_10(reverse_value, VALUE_LEN, base10_buffer, MAX_TX_TEXT_WIDTH);
+    char base10_buffer[VALUE_BASE10_LEN - 2];
+    unsigned int buffer_len;
+    // the digits leave room for the decimal point and the terminating null.
+    CHECK_SW(encode_base_10(reverse_value,
+                            VALUE_LEN,
+                            base10_buffer,
+                            min(sizeof(base10_buffer), dest_len - 2),
+                            &buffer_len));
 
     // place the decimal place.
     unsigned int dec_place_ix = buffer_len - DECIMAL_PLACE_OFFSET;
@@ -376,12 +322,37 @@ static void to_base10_100m(char *dest, const unsigned char *value, const unsigne
         memmove(dest + dec_place_ix, TXT_PERIOD, sizeof(TXT_PERIOD));
         memmove(dest, base10_buffer, dec_place_ix);
         memmove(dest + dec_place_ix + 1, base10_buffer + dec_place_ix, buffer_len - dec_place_ix);
+        dest[buffer_len + 1] = '\0';
+    }
+    return SW_OK;
+}
+
+/** reads a little endian tx.output.value. */
+uint64_t value_to_uint64(const unsigned char *value) {
+    uint64_t result = 0;
+    for (int ix = VALUE_LEN - 1; ix >= 0; ix--) {
+        result = (result << 8) | value[ix];
+    }
+    return result;
+}
+
+/** writes a little endian tx.output.value. */
+void uint64_to_value(unsigned char *value, uint64_t in) {
+    for (int ix = 0; ix < VALUE_LEN; ix++) {
+        value[ix] = in & 0xFF;
+        in >>= 8;
     }
 }
 
+/** hash contexts of to_address and public_key_hash160, which never run at the same time. */
+static union {
+    cx_sha256_t sha256;
+    cx_ripemd160_t ripemd160;
+} hash_ctx;
+
 /** converts a NEO scripthas to a NEO address by adding a checksum and encoding in base58 */
-static void to_address(char *dest, unsigned int dest_len, const unsigned char *script_hash) {
-    static cx_sha256_t address_hash;
+unsigned short to_address(char *dest, unsigned int dest_len, const unsigned char *script_hash) {
+    cx_sha256_t *address_hash = &hash_ctx.sha256;
     unsigned char address_hash_result_0[SHA256_HASH_LEN];
     unsigned char address_hash_result_1[SHA256_HASH_LEN];
 
@@ -391,33 +362,36 @@ static void to_address(char *dest, unsigned int dest_len, const unsigned char *s
     memmove(address + 1, script_hash, SCRIPT_HASH_LEN);
 
     // do a sha256 hash of the address twice.
-    cx_sha256_init(&address_hash);
-    CX_ASSERT(cx_hash_no_throw(&address_hash.header,
-                               CX_LAST,
-                               address,
-                               SCRIPT_HASH_LEN + 1,
-                               address_hash_result_0,
-                               32));
-    cx_sha256_init(&address_hash);
-    CX_ASSERT(cx_hash_no_throw(&address_hash.header,
-                               CX_LAST,
-                               address_hash_result_0,
-                               SHA256_HASH_LEN,
-                               address_hash_result_1,
-                               32));
+    PROFILE_STAGE(STAGE_ADDRESS_HASH, SCRIPT_HASH_LEN + 1 + SHA256_HASH_LEN);
+    cx_sha256_init(address_hash);
+    if (cx_hash_no_throw(&address_hash->header,
+                         CX_LAST,
+                         address,
+                         SCRIPT_HASH_LEN + 1,
+                         address_hash_result_0,
+                         32) != CX_OK) {
+        return 0x6D00;
+    }
+    cx_sha256_init(address_hash);
+    if (cx_hash_no_throw(&address_hash->header,
+                         CX_LAST,
+                         address_hash_result_0,
+                         SHA256_HASH_LEN,
+                         address_hash_result_1,
+                         32) != CX_OK) {
+        return 0x6D00;
+    }
 
     // add the first bytes of the hash as a checksum at the end of the address.
     memmove(address + 1 + SCRIPT_HASH_LEN, address_hash_result_1, SCRIPT_HASH_CHECKSUM_LEN);
 
-    // encode the version + address + cehcksum in base58
-    unsigned int encode_len = encode_base_58(address, ADDRESS_LEN, dest, dest_len);
+    // encode the version + address + cehcksum in base58, leaving room for the null terminator.
+    unsigned int encode_len;
+    CHECK_SW(encode_base_58(address, ADDRESS_LEN, dest, dest_len - 1, &encode_len));
 
     // Add a null terminator to the end of the string.
-    // Base 58 address length should be inferior to dest_len so we can safely add the null
-    // terminator.
-    LEDGER_ASSERT(encode_len < dest_len,
-                  "to_address : Base 58 address length too long for dest_len.");
     dest[encode_len] = '\0';
+    return SW_OK;
 }
 
 /** converts a byte array in src to a hex array in dest, using only dest_len bytes of dest before
@@ -451,6 +425,56 @@ static bool is_asset_id(const unsigned char *asset_id, const char *asset_id_hex)
     return true;
 }
 
+/** returns the label of the asset with the given id. */
+enum ASSET_LABEL get_asset_label(const unsigned char *asset_id) {
+    if (is_asset_id(asset_id, NEO_ASSET_ID)) {
+        return ASSET_LABEL_NEO;
+    } else if (is_asset_id(asset_id, GAS_ASSET_ID)) {
+        return ASSET_LABEL_GAS;
+    } else {
+        return ASSET_LABEL_UNKNOWN;
+    }
+}
+
+/** copies the text of an asset label into dest, including the null terminator. */
+static void copy_asset_label(char *dest, const enum ASSET_LABEL asset_label) {
+    switch (asset_label) {
+        case ASSET_LABEL_NEO:
+            memmove(dest, TXT_ASSET_NEO, sizeof(TXT_ASSET_NEO));
+            break;
+        case ASSET_LABEL_GAS:
+            memmove(dest, TXT_ASSET_GAS, sizeof(TXT_ASSET_GAS));
+            break;
+        default:
+            memmove(dest, TXT_ASSET_UNKNOWN, sizeof(TXT_ASSET_UNKNOWN));
+            break;
+    }
+}
+
+/** returns the label of a transaction type, or NULL if the type is unknown. */
+static const char *get_tx_type_label(const enum TX_TYPE trans_type) {
+    switch (trans_type) {
+        case TX_MINER:
+            return TX_MINER_NM;
+        case TX_ISSUE:
+            return TX_ISSUE_NM;
+        case TX_CLAIM:
+            return TX_CLAIM_NM;
+        case TX_ENROLL:
+            return TX_ENROLL_NM;
+        case TX_REGISTER:
+            return TX_REGISTER_NM;
+        case TX_CONTRACT:
+            return TX_CONTRACT_NM;
+        case TX_PUBLISH:
+            return TX_PUBLISH_NM;
+        case TX_INVOKE:
+            return TX_INVOKE_NM;
+        default:
+            return NULL;
+    }
+}
+
 /** returns the minimum of two ints. */
 static unsigned int min(unsigned int i0, unsigned int i1) {
     if (i0 < i1) {
@@ -461,103 +485,132 @@ static unsigned int min(unsigned int i0, unsigned int i1) {
 }
 
 /** skips the given number of bytes in the raw_tx buffer. If this goes off the end of the buffer,
- * throw an error. */
-static void skip_raw_tx(unsigned int tx_skip) {
+ * return an error. */
+static unsigned short skip_raw_tx(unsigned int tx_skip) {
     raw_tx_ix += tx_skip;
     if (raw_tx_ix >= raw_tx_len) {
-        hashTainted = 1;
-        THROW(0x6D03);
+        return 0x6D03;
     }
+    return SW_OK;
 }
 
-/** returns the number of bytes to read for the next varbytes array.
- *  Currently throws an error if the encoded value should be over 253,
+/** reads the number of bytes to read for the next varbytes array into num.
+ *  Currently returns an error if the encoded value should be over 253,
  *   which should never happen in this use case of a varbyte array
  */
-static unsigned char next_raw_tx_varbytes_num() {
-    unsigned char num = next_raw_tx();
-    switch (num) {
+static unsigned short next_raw_tx_varbytes_num(unsigned char *num) {
+    CHECK_SW(next_raw_tx(num));
+    switch (*num) {
         case 0xFD:
         case 0xFE:
         case 0xFF:
-            hashTainted = 1;
-            THROW(0x6D04);
-            break;
+            return 0x6D04;
         default:
             break;
     }
-    return num;
+    return SW_OK;
 }
 
-/** fills the array in arr with the given number of bytes from raw_tx. */
-static void next_raw_tx_arr(unsigned char *arr, unsigned int length) {
-    for (unsigned int ix = 0; ix < length; ix++) {
-        *(arr + ix) = next_raw_tx();
+/** fills the array in arr with the given number of bytes from raw_tx. If there are fewer, raw_tx_ix
+ * stops at the end of the buffer, as it does byte by byte, and an error is returned. */
+static unsigned short next_raw_tx_arr(unsigned char *arr, unsigned int length) {
+    unsigned int available = (raw_tx_ix < raw_tx_len) ? raw_tx_len - raw_tx_ix : 0;
+    if (length > available) {
+        raw_tx_ix += available;
+        return 0x6D05;
     }
+    memmove(arr, raw_tx + raw_tx_ix, length);
+    raw_tx_ix += length;
+    return SW_OK;
 }
 
-/** returns the next byte in raw_tx and increments raw_tx_ix. If this would increment raw_tx_ix over
- * the end of the buffer, throw an error. */
-static unsigned char next_raw_tx() {
+/** reads the next byte in raw_tx into out and increments raw_tx_ix. If this would increment
+ * raw_tx_ix over the end of the buffer, return an error. */
+static unsigned short next_raw_tx(unsigned char *out) {
     if (raw_tx_ix < raw_tx_len) {
-        unsigned char retval = raw_tx[raw_tx_ix];
+        *out = raw_tx[raw_tx_ix];
         raw_tx_ix += 1;
-        return retval;
+        return SW_OK;
     } else {
-        hashTainted = 1;
-        THROW(0x6D05);
-        return 0;
+        return 0x6D05;
+    }
+}
+
+/** fill screen scr_ix of tx_desc with label and an amount of the asset asset_label. fails rather
+ * than cut the amount short when it does not fit the screen. */
+static unsigned short display_amount(unsigned int scr_ix,
+                                     const char *label,
+                                     const char *asset_label,
+                                     uint64_t amount) {
+    unsigned char value[VALUE_LEN];
+    char value_base10[VALUE_BASE10_LEN];
+    char text[LABEL_VALUE_LEN + 1];
+
+    uint64_to_value(value, amount);
+    memset(value_base10, '\0', sizeof(value_base10));
+    CHECK_SW(to_base10_100m(value_base10, value, sizeof(value_base10)));
+    if (snprintf(text, sizeof(text), "%s %s", asset_label, value_base10) >= (int) sizeof(text)) {
+        return 0x6D23;
     }
+    display_label_value(scr_ix, label, text);
+    return SW_OK;
 }
 
-/** parse the raw transaction in raw_tx and fill up the screens in tx_desc. */
-unsigned char display_tx_desc() {
+/** fill the INPUTS_SCREENS screens of tx_desc from scr_ix with the NEO and GAS totals of the
+ * inputs. on bagl devices each asset has its own screen, so that its amount is not cut short. */
+static unsigned short display_inputs(unsigned int scr_ix, uint64_t input_neo, uint64_t input_gas) {
+#ifdef HAVE_BAGL
+    CHECK_SW(display_amount(scr_ix, TXT_INPUTS, TXT_ASSET_NEO, input_neo));
+    CHECK_SW(display_amount(scr_ix + 1, TXT_INPUTS, TXT_ASSET_GAS, input_gas));
+#else
+    unsigned char value[VALUE_LEN];
+    char neo_base10[VALUE_BASE10_LEN];
+    char gas_base10[VALUE_BASE10_LEN];
+
+    memset(neo_base10, '\0', sizeof(neo_base10));
+    uint64_to_value(value, input_neo);
+    CHECK_SW(to_base10_100m(neo_base10, value, sizeof(neo_base10)));
+    memset(gas_base10, '\0', sizeof(gas_base10));
+    uint64_to_value(value, input_gas);
+    CHECK_SW(to_base10_100m(gas_base10, value, sizeof(gas_base10)));
+
+    memset(tx_desc[scr_ix], '\0', CURR_TX_DESC_LEN);
+    memmove(tx_desc[scr_ix][0], TXT_INPUTS, sizeof(TXT_INPUTS));
+    if (snprintf(tx_desc[scr_ix][1],
+                 sizeof(tx_desc[scr_ix][1]),
+                 "%s %s, %s %s",
+                 TXT_ASSET_NEO,
+                 neo_base10,
+                 TXT_ASSET_GAS,
+                 gas_base10) >= (int) sizeof(tx_desc[scr_ix][1])) {
+        return 0x6D23;
+    }
+#endif
+    return SW_OK;
+}
+
+/** parse the raw transaction in raw_tx and fill up the screens in tx_desc. on a parse error,
+ * raw_tx_ix is where the parser stopped. */
+unsigned short display_tx_desc() {
     unsigned int scr_ix = 0;
     char hex_buffer[MAX_TX_TEXT_WIDTH];
     unsigned int hex_buffer_len = 0;
 
-    enum TX_TYPE trans_type = next_raw_tx();
+    memset(&tx_summary, 0, sizeof(tx_summary));
+    PROFILE_STAGE(STAGE_PARSE, raw_tx_len);
+
+    unsigned char trans_type;
+    CHECK_SW(next_raw_tx(&trans_type));
+    tx_summary.tx_type = trans_type;
     if (SHOW_TX_TYPE) {
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             // add transaction type screen.
             memmove(tx_desc[scr_ix][0], TXT_BLANK, sizeof(TXT_BLANK));
-            switch (trans_type) {
-                case TX_MINER:
-                    memmove(tx_desc[scr_ix][1], TX_MINER_NM, sizeof(TX_MINER_NM));
-                    break;
-
-                case TX_ISSUE:
-                    memmove(tx_desc[scr_ix][1], TX_ISSUE_NM, sizeof(TX_ISSUE_NM));
-                    break;
-
-                case TX_CLAIM:
-                    memmove(tx_desc[scr_ix][1], TX_CLAIM_NM, sizeof(TX_CLAIM_NM));
-                    break;
-
-                case TX_ENROLL:
-                    memmove(tx_desc[scr_ix][1], TX_ENROLL_NM, sizeof(TX_ENROLL_NM));
-                    break;
-
-                case TX_REGISTER:
-                    memmove(tx_desc[scr_ix][1], TX_REGISTER_NM, sizeof(TX_REGISTER_NM));
-                    break;
-
-                case TX_CONTRACT:
-                    memmove(tx_desc[scr_ix][1], TX_CONTRACT_NM, sizeof(TX_CONTRACT_NM));
-                    break;
-
-                case TX_PUBLISH:
-                    memmove(tx_desc[scr_ix][1], TX_PUBLISH_NM, sizeof(TX_PUBLISH_NM));
-                    break;
-
-                case TX_INVOKE:
-                    memmove(tx_desc[scr_ix][1], TX_INVOKE_NM, sizeof(TX_INVOKE_NM));
-                    break;
-
-                default:
-                    hashTainted = 1;
-                    THROW(0x6D06);
+            const char *tx_type_label = get_tx_type_label(trans_type);
+            if (tx_type_label == NULL) {
+                return 0x6D06;
             }
+            memmove(tx_desc[scr_ix][1], tx_type_label, strlen(tx_type_label) + 1);
 
             if (SHOW_TX_LEN) {
                 hex_buffer_len = min(MAX_HEX_BUFFER_LEN, sizeof(raw_tx_len)) * 2;
@@ -571,7 +624,8 @@ unsigned char display_tx_desc() {
     }
 
     // the version screen.
-    unsigned char version = next_raw_tx();
+    unsigned char version;
+    CHECK_SW(next_raw_tx(&version));
     if (SHOW_VERSION) {
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             memmove(tx_desc[scr_ix][0], TXT_VERSION, sizeof(TXT_VERSION));
@@ -590,7 +644,8 @@ unsigned char display_tx_desc() {
     // the exclusive data screen.
     switch (trans_type) {
         case TX_CLAIM: {
-            unsigned char num_coin_claims = next_raw_tx_varbytes_num();
+            unsigned char num_coin_claims;
+            CHECK_SW(next_raw_tx_varbytes_num(&num_coin_claims));
             if (SHOW_EXCLUSIVE_DATA) {
                 if (scr_ix < MAX_TX_TEXT_SCREENS) {
                     memmove(tx_desc[scr_ix][0], TXT_CLAIMS, sizeof(TXT_CLAIMS));
@@ -605,14 +660,15 @@ unsigned char display_tx_desc() {
                     scr_ix++;
                 }
             }
-            skip_raw_tx(num_coin_claims * COIN_REFERENCES_LEN);
+            CHECK_SW(skip_raw_tx(num_coin_claims * COIN_REFERENCES_LEN));
         } break;
         case TX_INVOKE: {
-            unsigned char script_len = next_raw_tx_varbytes_num();
-            skip_raw_tx(script_len);
+            unsigned char script_len;
+            CHECK_SW(next_raw_tx_varbytes_num(&script_len));
+            CHECK_SW(skip_raw_tx(script_len));
             if (version >= 1) {
                 // UInt64.SIZE = 8
-                skip_raw_tx(8);
+                CHECK_SW(skip_raw_tx(8));
             }
         } break;
         default:
@@ -620,7 +676,8 @@ unsigned char display_tx_desc() {
     }
 
     //  attributes screen.
-    unsigned char num_attr = next_raw_tx_varbytes_num();
+    unsigned char num_attr;
+    CHECK_SW(next_raw_tx_varbytes_num(&num_attr));
     if (SHOW_NUM_ATTRIBUTES) {
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             memmove(tx_desc[scr_ix][0], TXT_NUM_ATTR, sizeof(TXT_NUM_ATTR));
@@ -637,7 +694,9 @@ unsigned char display_tx_desc() {
     }
 
     for (int attr_ix = 0; attr_ix < num_attr; attr_ix++) {
-        enum TransactionAttributeUsage attr_usage = next_raw_tx();
+        unsigned char attr_usage;
+        unsigned char attr_len;
+        CHECK_SW(next_raw_tx(&attr_usage));
         switch (attr_usage) {
             case CONTRACT_HASH:
             case VOTE:
@@ -656,20 +715,21 @@ unsigned char display_tx_desc() {
             case HASH13:
             case HASH14:
             case HASH15:
-                skip_raw_tx(32);
+                CHECK_SW(skip_raw_tx(32));
                 break;
 
             case ECDH02:
             case ECDH03:
-                skip_raw_tx(32);
+                CHECK_SW(skip_raw_tx(32));
                 break;
 
             case SCRIPT:
-                skip_raw_tx(20);
+                CHECK_SW(skip_raw_tx(20));
                 break;
 
             case DESCRIPTION_URL:
-                skip_raw_tx(next_raw_tx());
+                CHECK_SW(next_raw_tx(&attr_len));
+                CHECK_SW(skip_raw_tx(attr_len));
                 break;
 
             case DESCRIPTION:
@@ -689,17 +749,18 @@ unsigned char display_tx_desc() {
             case REMARK13:
             case REMARK14:
             case REMARK15:
-                skip_raw_tx(next_raw_tx_varbytes_num());
+                CHECK_SW(next_raw_tx_varbytes_num(&attr_len));
+                CHECK_SW(skip_raw_tx(attr_len));
                 break;
 
             default:
-                hashTainted = 1;
-                THROW(0x6D07);
+                return 0x6D07;
         }
     }
 
     // Coin Reference screen.
-    unsigned char num_coin_references = next_raw_tx_varbytes_num();
+    unsigned char num_coin_references;
+    CHECK_SW(next_raw_tx_varbytes_num(&num_coin_references));
     if (SHOW_NUM_COIN_REFERENCES) {
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             memmove(tx_desc[scr_ix][0], TXT_NUM_TXIN, sizeof(TXT_NUM_TXIN));
@@ -714,10 +775,29 @@ unsigned char display_tx_desc() {
             scr_ix++;
         }
     }
-    skip_raw_tx(num_coin_references * COIN_REFERENCES_LEN);
+    // with an attestation for every input, the input totals and the fee can be shown.
+    bool inputs_attested = (num_coin_references > 0);
+    uint64_t input_neo = 0;
+    uint64_t input_gas = 0;
+    for (unsigned int ix = 0; ix < num_coin_references; ix++) {
+        const unsigned char *coin_reference = raw_tx + raw_tx_ix;
+        CHECK_SW(skip_raw_tx(COIN_REFERENCES_LEN));
+
+        const attested_input_t *input = attest_find_input(coin_reference);
+        if (input == NULL) {
+            inputs_attested = false;
+        } else if (input->asset_label == ASSET_LABEL_NEO) {
+            input_neo += input->value;
+        } else if (input->asset_label == ASSET_LABEL_GAS) {
+            input_gas += input->value;
+        }
+    }
 
     // transaction output screen.
-    unsigned char num_tx_outs = next_raw_tx_varbytes_num();
+    unsigned char num_tx_outs;
+    CHECK_SW(next_raw_tx_varbytes_num(&num_tx_outs));
+    tx_summary.num_tx_outs = num_tx_outs;
+    tx_summary.tx_outs_ix = raw_tx_ix;
     if (SHOW_NUM_TX_OUTS) {
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             memmove(tx_desc[scr_ix][0], TXT_NUM_TXOUT, sizeof(TXT_NUM_TXOUT));
@@ -754,36 +834,51 @@ unsigned char display_tx_desc() {
     char *address_base58_1 = address_base58 + address_base58_len_0;
     char *address_base58_2 = address_base58 + address_base58_len_0 + address_base58_len_1;
 #endif
+    uint64_t output_gas = 0;
     for (unsigned int ix = 0; ix < num_tx_outs; ix++) {
-        next_raw_tx_arr(asset_id, ASSET_ID_LEN);
-        next_raw_tx_arr(value, VALUE_LEN);
-        next_raw_tx_arr(script_hash, SCRIPT_HASH_LEN);
+        CHECK_SW(next_raw_tx_arr(asset_id, ASSET_ID_LEN));
+        CHECK_SW(next_raw_tx_arr(value, VALUE_LEN));
+        CHECK_SW(next_raw_tx_arr(script_hash, SCRIPT_HASH_LEN));
         memset(address_base58, 0, sizeof(address_base58));
-        to_address(address_base58, sizeof(address_base58), script_hash);
+        CHECK_SW(to_address(address_base58, sizeof(address_base58), script_hash));
+
+        enum ASSET_LABEL asset_label = get_asset_label(asset_id);
+        if (asset_label == ASSET_LABEL_GAS) {
+            output_gas += value_to_uint64(value);
+        }
+        if (ix == 0) {
+            tx_summary.asset_label = asset_label;
+            memmove(tx_summary.value, value, VALUE_LEN);
+            memmove(tx_summary.script_hash, script_hash, SCRIPT_HASH_LEN);
+        }
 
         // asset_id and value screen
         if (scr_ix < MAX_TX_TEXT_SCREENS) {
             memset(tx_desc[scr_ix], '\0', CURR_TX_DESC_LEN);
             // asset id
-            if (is_asset_id(asset_id, NEO_ASSET_ID)) {
-                memmove(tx_desc[scr_ix][0], TXT_ASSET_NEO, sizeof(TXT_ASSET_NEO));
-            } else if (is_asset_id(asset_id, GAS_ASSET_ID)) {
-                memmove(tx_desc[scr_ix][0], TXT_ASSET_GAS, sizeof(TXT_ASSET_GAS));
-            } else {
-                memmove(tx_desc[scr_ix][0], TXT_ASSET_UNKNOWN, sizeof(TXT_ASSET_UNKNOWN));
-            }
+            copy_asset_label(tx_desc[scr_ix][0], asset_label);
 
             // value, base 10.
-            to_base10_100m(tx_desc[scr_ix][1], value, MAX_TX_TEXT_WIDTH);
-
 #ifdef HAVE_NBGL
-            snprintf(tx_desc[scr_ix][2],
-                     sizeof(tx_desc[scr_ix][2]),
-                     "%s %s",
-                     tx_desc[scr_ix][0],
-                     tx_desc[scr_ix][1]);
+            // the amount line is formatted from copies, snprintf must not read tx_desc as it
+            // writes it.
+            char asset_text[sizeof(TXT_ASSET_UNKNOWN)];
+            char value_base10[VALUE_BASE10_LEN];
+            copy_asset_label(asset_text, asset_label);
+            memset(value_base10, '\0', sizeof(value_base10));
+            CHECK_SW(to_base10_100m(value_base10, value, sizeof(value_base10)));
+            memmove(tx_desc[scr_ix][1], value_base10, sizeof(value_base10));
+            if (snprintf(tx_desc[scr_ix][2],
+                         sizeof(tx_desc[scr_ix][2]),
+                         "%s %s",
+                         asset_text,
+                         value_base10) >= (int) sizeof(tx_desc[scr_ix][2])) {
+                return 0x6D23;
+            }
 #endif
 #ifdef HAVE_BAGL
+            CHECK_SW(to_base10_100m(tx_desc[scr_ix][1], value, MAX_TX_TEXT_WIDTH));
+
             // value, base 16.
             if (SHOW_VALUE_HEX) {
                 hex_buffer_len = min(MAX_HEX_BUFFER_LEN, VALUE_LEN) * 2;
@@ -829,11 +924,129 @@ unsigned char display_tx_desc() {
         }
     }
 
-    max_scr_ix = scr_ix;
+    // inputs and fee screens, the fee is the GAS the outputs leave out.
+    if (inputs_attested && (input_gas >= output_gas)) {
+        tx_summary.fee_known = true;
+        tx_summary.fee = input_gas - output_gas;
+        if (scr_ix + INPUTS_SCREENS + 1 <= MAX_TX_TEXT_SCREENS) {
+            tx_summary.inputs_scr_ix = scr_ix;
+            CHECK_SW(display_inputs(scr_ix, input_neo, input_gas));
+            scr_ix += INPUTS_SCREENS;
+            CHECK_SW(display_amount(scr_ix++, TXT_FEE, TXT_ASSET_GAS, tx_summary.fee));
+        }
+    }
 
-    memmove(curr_tx_desc, tx_desc[curr_scr_ix], CURR_TX_DESC_LEN);
+    start_tx_desc(scr_ix);
 
-    return 1;
+    return SW_OK;
+}
+
+/** fill the two tx_desc screens of transaction batch_ix out of batch_count in a batch review: the
+ * position, type and first output amount, then the first output address. */
+unsigned short display_batch_tx_desc(unsigned char batch_ix,
+                                     unsigned char batch_count,
+                                     const tx_summary_t *summary) {
+    unsigned int scr_ix = 2 * batch_ix;
+    if (scr_ix + 1 >= MAX_TX_TEXT_SCREENS) {
+        return 0x6D15;
+    }
+
+    const char *tx_type_label = get_tx_type_label(summary->tx_type);
+    if (tx_type_label == NULL) {
+        tx_type_label = TXT_ASSET_UNKNOWN;
+    }
+
+    // position, type and amount screen
+    memset(tx_desc[scr_ix], '\0', CURR_TX_DESC_LEN);
+    memset(tx_desc[scr_ix + 1], '\0', CURR_TX_DESC_LEN);
+#ifdef HAVE_BAGL
+    snprintf(tx_desc[scr_ix][0],
+             sizeof(tx_desc[scr_ix][0]),
+             "%d/%d %s",
+             batch_ix + 1,
+             batch_count,
+             tx_type_label);
+    if (summary->num_tx_outs == 0) {
+        memmove(tx_desc[scr_ix][1], TXT_NO_OUTPUT, sizeof(TXT_NO_OUTPUT));
+        return SW_OK;
+    }
+    copy_asset_label(tx_desc[scr_ix][1], summary->asset_label);
+    CHECK_SW(to_base10_100m(tx_desc[scr_ix][2], summary->value, MAX_TX_TEXT_WIDTH));
+#else   // HAVE_NBGL
+    char value_base10[VALUE_BASE10_LEN];
+    char asset_label[sizeof(TXT_ASSET_UNKNOWN)];
+    snprintf(tx_desc[scr_ix][0],
+             sizeof(tx_desc[scr_ix][0]),
+             "Transaction %d/%d",
+             batch_ix + 1,
+             batch_count);
+    strncpy(tx_desc[scr_ix][1], tx_type_label, sizeof(tx_desc[scr_ix][1]) - 1);
+    if (summary->num_tx_outs == 0) {
+        memmove(tx_desc[scr_ix][2], TXT_NO_OUTPUT, sizeof(TXT_NO_OUTPUT));
+        return SW_OK;
+    }
+    copy_asset_label(asset_label, summary->asset_label);
+    memset(value_base10, '\0', sizeof(value_base10));
+    CHECK_SW(to_base10_100m(value_base10, summary->value, sizeof(value_base10)));
+    if (snprintf(tx_desc[scr_ix][2],
+                 sizeof(tx_desc[scr_ix][2]),
+                 "%s %s",
+                 asset_label,
+                 value_base10) >= (int) sizeof(tx_desc[scr_ix][2])) {
+        return 0x6D23;
+    }
+#endif
+    scr_ix++;
+
+    // address screen
+    char address_base58[ADDRESS_BASE58_LEN + 1];
+    memset(address_base58, 0, sizeof(address_base58));
+    CHECK_SW(to_address(address_base58, sizeof(address_base58), summary->script_hash));
+#ifdef HAVE_BAGL
+    memmove(tx_desc[scr_ix][0], address_base58, 11);
+    memmove(tx_desc[scr_ix][1], address_base58 + 11, 11);
+    memmove(tx_desc[scr_ix][2], address_base58 + 22, 12);
+#else
+    strncpy(tx_desc[scr_ix][0], address_base58, sizeof(tx_desc[scr_ix][0]));
+#endif
+    return SW_OK;
+}
+
+#ifdef HAVE_NBGL
+unsigned char review_pairs(review_pair_t *pairs) {
+    pairs[0].item = "Type";
+    pairs[0].value = tx_desc[0][1];
+    pairs[1].item = "Amount";
+    pairs[1].value = tx_desc[1][2];
+    pairs[2].item = "Destination Address";
+    pairs[2].value = tx_desc[2][0];
+    if (tx_summary.inputs_scr_ix == 0) {
+        return 3;
+    }
+
+    // the inputs and fee, when every input is attested.
+    pairs[3].item = tx_desc[tx_summary.inputs_scr_ix][0];
+    pairs[3].value = tx_desc[tx_summary.inputs_scr_ix][1];
+    pairs[4].item = tx_desc[tx_summary.inputs_scr_ix + INPUTS_SCREENS][0];
+    pairs[4].value = tx_desc[tx_summary.inputs_scr_ix + INPUTS_SCREENS][1];
+    return 5;
+}
+#endif
+
+/** fill screen scr_ix of tx_desc with a label and its value. on narrow screens the value is
+ * split over the two lines under the label. */
+void display_label_value(unsigned int scr_ix, const char *label, const char *value) {
+    memset(tx_desc[scr_ix], '\0', CURR_TX_DESC_LEN);
+    strncpy(tx_desc[scr_ix][0], label, MAX_TX_TEXT_WIDTH - 1);
+    // the line was cleared, so it stays null terminated.
+    unsigned int value_len = strlen(value);
+    unsigned int line_len = MAX_TX_TEXT_WIDTH - 1;
+    memmove(tx_desc[scr_ix][1], value, min(value_len, line_len));
+#ifdef HAVE_BAGL
+    if (value_len > line_len) {
+        memmove(tx_desc[scr_ix][2], value + line_len, min(value_len - line_len, line_len));
+    }
+#endif
 }
 
 void display_no_public_key() {
@@ -851,49 +1064,69 @@ void display_no_public_key() {
 }
 
 void public_key_hash160(unsigned char *in, unsigned short inlen, unsigned char *out) {
-    union {
-        cx_sha256_t shasha;
-        cx_ripemd160_t riprip;
-    } u;
     unsigned char buffer[32];
 
-    cx_sha256_init(&u.shasha);
-    CX_ASSERT(cx_hash_no_throw(&u.shasha.header, CX_LAST, in, inlen, buffer, 32));
-    cx_ripemd160_init(&u.riprip);
-    CX_ASSERT(cx_hash_no_throw(&u.riprip.header, CX_LAST, buffer, 32, out, 20));
+    cx_sha256_init(&hash_ctx.sha256);
+    CX_ASSERT(cx_hash_no_throw(&hash_ctx.sha256.header, CX_LAST, in, inlen, buffer, 32));
+    cx_ripemd160_init(&hash_ctx.ripemd160);
+    CX_ASSERT(cx_hash_no_throw(&hash_ctx.ripemd160.header, CX_LAST, buffer, 32, out, 20));
 }
 
-void display_public_key(const unsigned char *public_key) {
-#ifdef HAVE_BAGL
-    memmove(address58[0], TXT_BLANK, sizeof(TXT_BLANK));
-    memmove(address58[1], TXT_BLANK, sizeof(TXT_BLANK));
-    memmove(address58[2], TXT_BLANK, sizeof(TXT_BLANK));
-#else
-    memset(address58[0], 0, sizeof(address58[0]));
-#endif
+void public_key_to_script_hash(const unsigned char *public_key, unsigned char *script_hash) {
     // from https://github.com/CityOfZion/neon-js core.js
+    unsigned char verification_script[VERIFICATION_SCRIPT_LEN];
+    public_key_to_verification_script(public_key, verification_script);
+
+    for (int i = 0; i < SCRIPT_HASH_LEN; i++) {
+        script_hash[i] = 0x00;
+    }
+
+    public_key_hash160(verification_script, sizeof(verification_script), script_hash);
+}
+
+void public_key_to_verification_script(const unsigned char *public_key,
+                                       unsigned char *verification_script) {
     unsigned char public_key_encoded[33];
     public_key_encoded[0] = ((public_key[64] & 1) ? 0x03 : 0x02);
     memmove(public_key_encoded + 1, public_key + 1, 32);
 
-    unsigned char verification_script[35];
     verification_script[0] = 0x21;
     memmove(verification_script + 1, public_key_encoded, sizeof(public_key_encoded));
-    verification_script[sizeof(verification_script) - 1] = 0xAC;
+    verification_script[VERIFICATION_SCRIPT_LEN - 1] = 0xAC;
+}
 
-    unsigned char script_hash[SCRIPT_HASH_LEN];
-    for (int i = 0; i < SCRIPT_HASH_LEN; i++) {
-        script_hash[i] = 0x00;
-    }
+unsigned int write_witness(unsigned char *out,
+                           const unsigned char *raw_sig,
+                           const unsigned char *public_key) {
+    unsigned int out_ix = 0;
 
-    public_key_hash160(verification_script, sizeof(verification_script), script_hash);
-    unsigned char script_hash_rev[SCRIPT_HASH_LEN];
-    for (int i = 0; i < SCRIPT_HASH_LEN; i++) {
-        script_hash_rev[i] = script_hash[SCRIPT_HASH_LEN - (i + 1)];
-    }
+    // invocation script: push the signature.
+    out[out_ix++] = 1 + 64;
+    out[out_ix++] = 0x40;
+    memmove(out + out_ix, raw_sig, 64);
+    out_ix += 64;
+
+    // verification script: check the signature against the public key.
+    out[out_ix++] = VERIFICATION_SCRIPT_LEN;
+    public_key_to_verification_script(public_key, out + out_ix);
+    out_ix += VERIFICATION_SCRIPT_LEN;
+
+    return out_ix;
+}
+
+unsigned short display_public_key(const unsigned char *public_key) {
+#ifdef HAVE_BAGL
+    memmove(address58[0], TXT_BLANK, sizeof(TXT_BLANK));
+    memmove(address58[1], TXT_BLANK, sizeof(TXT_BLANK));
+    memmove(address58[2], TXT_BLANK, sizeof(TXT_BLANK));
+#else
+    memset(address58[0], 0, sizeof(address58[0]));
+#endif
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    public_key_to_script_hash(public_key, script_hash);
 
     char address_base58[ADDRESS_BASE58_LEN + 1] = {0};
-    to_address(address_base58, sizeof(address_base58), script_hash);
+    CHECK_SW(to_address(address_base58, sizeof(address_base58), script_hash));
 #ifdef HAVE_BAGL
     unsigned int address_base58_len_0 = 11;
     unsigned int address_base58_len_1 = 11;
@@ -907,4 +1140,5 @@ void display_public_key(const unsigned char *public_key) {
 #else  // HAVE_NBGL
     strncpy(address58[0], address_base58, sizeof(address58[0]));
 #endif
+    return SW_OK;
 }
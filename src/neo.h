@@ -11,13 +11,221 @@
 #include "os_io_seproxyhal.h"
 #include "ui.h"
 
-/** parse the raw transaction in raw_tx and fill up the screens in tx_desc. */
-unsigned char display_tx_desc(void);
+/**
+ * transaction types.
+ *
+ * Currently only Claim and Contract are tested, as they are the only ones supported by the current
+ * wallets.
+ */
+enum TX_TYPE {
+    TX_MINER = 0x00,
+    TX_ISSUE = 0x01,
+    TX_CLAIM = 0x02,
+    TX_ENROLL = 0x20,
+    TX_REGISTER = 0x40,
+    TX_CONTRACT = 0x80,
+    TX_PUBLISH = 0xD0,
+    TX_INVOKE = 0xD1
+};
+
+/**
+ * transaction attributes.
+ *
+ * currently there's no support in wallets for adding attributes to a contract, but the types are as
+ * listed below.
+ */
+enum TransactionAttributeUsage {
+    CONTRACT_HASH = 0x00,
+
+    ECDH02 = 0x02,
+    ECDH03 = 0x03,
+
+    SCRIPT = 0x20,
+
+    VOTE = 0x30,
+
+    DESCRIPTION_URL = 0x81,
+    DESCRIPTION = 0x90,
+
+    HASH1 = 0xa1,
+    HASH2 = 0xa2,
+    HASH3 = 0xa3,
+    HASH4 = 0xa4,
+    HASH5 = 0xa5,
+    HASH6 = 0xa6,
+    HASH7 = 0xa7,
+    HASH8 = 0xa8,
+    HASH9 = 0xa9,
+    HASH10 = 0xaa,
+    HASH11 = 0xab,
+    HASH12 = 0xac,
+    HASH13 = 0xad,
+    HASH14 = 0xae,
+    HASH15 = 0xaf,
+
+    REMARK = 0xf0,
+    REMARK1 = 0xf1,
+    REMARK2 = 0xf2,
+    REMARK3 = 0xf3,
+    REMARK4 = 0xf4,
+    REMARK5 = 0xf5,
+    REMARK6 = 0xf6,
+    REMARK7 = 0xf7,
+    REMARK8 = 0xf8,
+    REMARK9 = 0xf9,
+    REMARK10 = 0xfa,
+    REMARK11 = 0xfb,
+    REMARK12 = 0xfc,
+    REMARK13 = 0xfd,
+    REMARK14 = 0xfe,
+    REMARK15 = 0xff
+};
+
+/** labels of the known assets. */
+enum ASSET_LABEL { ASSET_LABEL_UNKNOWN, ASSET_LABEL_NEO, ASSET_LABEL_GAS };
+
+/**
+ * each CoinReference has two fields:
+ *  UInt256 PrevHash = 32 bytes.
+ *  ushort PrevIndex = 2 bytes.
+ */
+#define COIN_REFERENCES_LEN (32 + 2)
+
+/** length of tx.output.asset_id */
+#define ASSET_ID_LEN 32
+
+/** length of tx.output.value */
+#define VALUE_LEN 8
+
+/** length of tx.output.script_hash */
+#define SCRIPT_HASH_LEN 20
+
+/** length of a tx.output, which is the length of <asset_id>+<value>+<script_hash> */
+#define TX_OUTPUT_LEN (ASSET_ID_LEN + VALUE_LEN + SCRIPT_HASH_LEN)
+
+/** length of a tx.output Address, after Base58 encoding. */
+#define ADDRESS_BASE58_LEN 34
+
+/** length of the verification script of a public key, <push 33>+<compressed key>+<CHECKSIG> */
+#define VERIFICATION_SCRIPT_LEN 35
+
+/** length of a serialized witness: the invocation script pushing a 64 byte signature and the
+ * verification script, each prefixed with its length. */
+#define WITNESS_LEN (1 + 1 + 64 + 1 + VERIFICATION_SCRIPT_LEN)
+
+/** summary of a parsed transaction: its type and its first output. */
+typedef struct {
+    /** the transaction type. */
+    unsigned char tx_type;
+
+    /** the number of outputs. */
+    unsigned char num_tx_outs;
+
+    /** index in raw_tx of the first output, the outputs follow each other. */
+    unsigned short tx_outs_ix;
+
+    /** index of the first of the INPUTS_SCREENS inputs screens in tx_desc, followed by the fee
+     * screen. zero if the inputs are not all attested. */
+    unsigned char inputs_scr_ix;
+
+    /** true if the inputs are all attested, so the fee is known. */
+    bool fee_known;
+
+    /** the fee, the GAS the outputs leave out of the inputs. */
+    uint64_t fee;
+
+    /** the label of the first output's asset, NEO, GAS or unknown. */
+    unsigned char asset_label;
+
+    /** the value of the first output. */
+    unsigned char value[VALUE_LEN];
+
+    /** the script hash the first output is sent to. */
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+} tx_summary_t;
+
+/** summary of the last transaction parsed by display_tx_desc. */
+extern tx_summary_t tx_summary;
+
+/** parse the raw transaction in raw_tx and fill up the screens in tx_desc, returns the status
+ * word. */
+unsigned short display_tx_desc(void);
+
+/** fill the two tx_desc screens of transaction batch_ix out of batch_count in a batch review,
+ * returns the status word. */
+unsigned short display_batch_tx_desc(unsigned char batch_ix,
+                                     unsigned char batch_count,
+                                     const tx_summary_t *summary);
+
+#ifdef HAVE_NBGL
+/** the most tag/value pairs of the review of a transaction. */
+#define REVIEW_PAIRS_MAX 5
+
+/** a tag and its value in the review of a transaction, pointing into tx_desc. */
+typedef struct {
+    const char *item;
+    const char *value;
+} review_pair_t;
+
+/** writes the tag/value pairs the review of the transaction parsed last shows, returns their
+ * count. */
+unsigned char review_pairs(review_pair_t *pairs);
+#endif
+
+/** the most characters of a value display_label_value shows: two lines under the label on bagl
+ * devices, one line on NBGL devices. */
+#ifdef HAVE_BAGL
+#define LABEL_VALUE_LEN (2 * (MAX_TX_TEXT_WIDTH - 1))
+#else
+#define LABEL_VALUE_LEN (MAX_TX_TEXT_WIDTH - 1)
+#endif
+
+/** length of the longest text of to_base10_100m and its null, "184467440737.09551615". */
+#define VALUE_BASE10_LEN 22
+
+/** the screens of the inputs in tx_desc: one per asset on bagl devices, one for both on NBGL
+ * devices. */
+#ifdef HAVE_BAGL
+#define INPUTS_SCREENS 2
+#else
+#define INPUTS_SCREENS 1
+#endif
+
+/** fill screen scr_ix of tx_desc with a label and its value. */
+void display_label_value(unsigned int scr_ix, const char *label, const char *value);
+
+/** converts an 8 byte little endian value to base10 with a decimal point 8 digits from the right,
+ * returns the status word. */
+unsigned short to_base10_100m(char *dest, const unsigned char *value, const unsigned int dest_len);
+
+/** reads a little endian tx.output.value. */
+uint64_t value_to_uint64(const unsigned char *value);
+
+/** writes a little endian tx.output.value. */
+void uint64_to_value(unsigned char *value, uint64_t in);
+
+/** converts a NEO scripthash to a NEO address, null terminated, returns the status word. */
+unsigned short to_address(char *dest, unsigned int dest_len, const unsigned char *script_hash);
+
+/** returns the label of the asset with the given id. */
+enum ASSET_LABEL get_asset_label(const unsigned char *asset_id);
+
+/** writes the verification script of a public key, assumes the key length is 65. */
+void public_key_to_verification_script(const unsigned char *public_key,
+                                       unsigned char *verification_script);
+
+/** writes the serialized witness of a 64 byte r||s signature by public_key, returns WITNESS_LEN. */
+unsigned int write_witness(unsigned char *out,
+                           const unsigned char *raw_sig,
+                           const unsigned char *public_key);
+
+/** writes the script hash of a public key, which is what its address encodes. */
+void public_key_to_script_hash(const unsigned char *public_key, unsigned char *script_hash);
 
 /** displays the "no public key" message, prior to a public key being requested. */
 void display_no_public_key(void);
 
-/** displays the public key, assumes length is 65. */
-void display_public_key(const unsigned char* public_key);
+/** displays the public key, assumes length is 65, returns the status word. */
+unsigned short display_public_key(const unsigned char* public_key);
 
 #endif  // NEO_H
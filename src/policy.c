@@ -0,0 +1,216 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include "policy.h"
+#include "crypto_helpers.h"
+#include "stage_profile.h"
+
+/** the policy of the session. it lives in RAM only, so it ends with the app. */
+policy_t policy;
+
+/** read a policy message of len bytes, it is held until the user approves it. the account's
+ * script hash is computed here, before the review, as it is shown to the user. */
+unsigned short policy_set(const unsigned char *in, unsigned int len) {
+    policy_clear();
+
+    if (len < POLICY_FIXED_LEN) {
+        return 0x6D18;
+    }
+    unsigned char asset_mask = *in++;
+    policy.max_tx_value = value_to_uint64(in);
+    in += VALUE_LEN;
+    policy.max_total_value = value_to_uint64(in);
+    in += VALUE_LEN;
+    policy.tx_count_left = *in++;
+    policy.destination_count = *in++;
+
+    if (asset_mask == POLICY_ASSET_NEO) {
+        policy.asset_label = ASSET_LABEL_NEO;
+    } else if (asset_mask == POLICY_ASSET_GAS) {
+        policy.asset_label = ASSET_LABEL_GAS;
+    }
+    if ((policy.asset_label == ASSET_LABEL_UNKNOWN) || (policy.tx_count_left == 0) ||
+        (policy.destination_count == 0) || (policy.destination_count > MAX_POLICY_DESTINATIONS) ||
+        (len != POLICY_FIXED_LEN + (policy.destination_count * SCRIPT_HASH_LEN))) {
+        policy_clear();
+        return 0x6D18;
+    }
+
+    for (unsigned char dest_ix = 0; dest_ix < policy.destination_count; dest_ix++) {
+        memmove(policy.destinations[dest_ix], in, SCRIPT_HASH_LEN);
+        in += SCRIPT_HASH_LEN;
+    }
+    memmove(policy.bip44_path, in, BIP44_BYTE_LENGTH);
+
+    /** BIP44 path, used to derive the private key from the mnemonic by calling
+     * os_perso_derive_node_bip32. */
+    const unsigned char *bip44_in = policy.bip44_path;
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    uint32_t i;
+    for (i = 0; i < BIP44_PATH_LEN; i++) {
+        bip44_path[i] =
+            (bip44_in[0] << 24) | (bip44_in[1] << 16) | (bip44_in[2] << 8) | (bip44_in[3]);
+        bip44_in += 4;
+    }
+
+    uint8_t raw_pubkey[65];
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    if (bip32_derive_get_pubkey_256(CX_CURVE_256R1,
+                                    bip44_path,
+                                    BIP44_PATH_LEN,
+                                    raw_pubkey,
+                                    NULL,
+                                    CX_SHA512) != CX_OK) {
+        policy_clear();
+        return 0x6D00;
+    }
+    public_key_to_script_hash(raw_pubkey, policy.change_script_hash);
+    return SW_OK;
+}
+
+/** the ticker of the asset of the policy. */
+static const char *policy_asset_ticker(void) {
+    return (policy.asset_label == ASSET_LABEL_NEO) ? "NEO" : "GAS";
+}
+
+/** writes a cap of the policy as the review shows it, the ticker of the asset then the value. */
+static unsigned short policy_cap_text(char *text, unsigned int text_len, uint64_t cap) {
+    unsigned char value[VALUE_LEN];
+    char value_base10[ADDRESS_BASE58_LEN + 1];
+    uint64_to_value(value, cap);
+    memset(value_base10, '\0', sizeof(value_base10));
+    CHECK_SW(to_base10_100m(value_base10, value, sizeof(value_base10)));
+    snprintf(text, text_len, "%s %s", policy_asset_ticker(), value_base10);
+    return SW_OK;
+}
+
+/** fill the tx_desc screens with the pending policy: the asset, the caps, the account and one
+ * screen per destination. */
+unsigned short policy_display_desc(void) {
+    char text[ADDRESS_BASE58_LEN + 1];
+    unsigned int scr_ix = 0;
+
+    display_label_value(scr_ix++, "Asset", policy_asset_ticker());
+
+    memset(text, '\0', sizeof(text));
+    CHECK_SW(policy_cap_text(text, sizeof(text), policy.max_tx_value));
+    display_label_value(scr_ix++, "Max per Tx", text);
+
+    memset(text, '\0', sizeof(text));
+    CHECK_SW(policy_cap_text(text, sizeof(text), policy.max_total_value));
+    display_label_value(scr_ix++, "Max Total", text);
+
+    snprintf(text, sizeof(text), "%d", policy.tx_count_left);
+    display_label_value(scr_ix++, "Max Tx Count", text);
+
+    memset(text, '\0', sizeof(text));
+    CHECK_SW(to_address(text, sizeof(text), policy.change_script_hash));
+    display_label_value(scr_ix++, "Account", text);
+
+    for (unsigned char dest_ix = 0; dest_ix < policy.destination_count; dest_ix++) {
+        char label[MAX_TX_TEXT_WIDTH];
+        snprintf(label, sizeof(label), "Destination %d", dest_ix + 1);
+        memset(text, '\0', sizeof(text));
+        CHECK_SW(to_address(text, sizeof(text), policy.destinations[dest_ix]));
+        display_label_value(scr_ix++, label, text);
+    }
+
+    start_tx_desc(scr_ix);
+    return SW_OK;
+}
+
+/** the user approved the pending policy. */
+void policy_approve(void) {
+    policy.total_value = 0;
+    policy.active = true;
+}
+
+/** true if script_hash is one of the destinations of the policy. */
+static bool is_policy_destination(const unsigned char *script_hash) {
+    for (unsigned char dest_ix = 0; dest_ix < policy.destination_count; dest_ix++) {
+        if (memcmp(policy.destinations[dest_ix], script_hash, SCRIPT_HASH_LEN) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** true if the transaction just parsed from raw_tx can be signed under the policy, in which case
+ * it is counted against the policy. it must be a contract transaction signed with the policy's key,
+ * whose outputs are all of the policy's asset and go either to an allowed destination or back to
+ * the account as change. its fee must be known. the value of the non change outputs, plus the fee
+ * under a GAS policy, must fit in both caps. a NEO policy allows no fee. */
+bool policy_consume_tx(void) {
+    if ((!policy.active) || (policy.tx_count_left == 0)) {
+        return false;
+    }
+    if ((tx_summary.tx_type != TX_CONTRACT) || (raw_tx_len < BIP44_BYTE_LENGTH)) {
+        return false;
+    }
+
+    unsigned int raw_tx_len_except_bip44 = raw_tx_len - BIP44_BYTE_LENGTH;
+    if (memcmp(raw_tx + raw_tx_len_except_bip44, policy.bip44_path, BIP44_BYTE_LENGTH) != 0) {
+        return false;
+    }
+
+    // display_tx_desc read the outputs, only check that they end before the BIP44 path.
+    if (tx_summary.tx_outs_ix + (tx_summary.num_tx_outs * (unsigned int) TX_OUTPUT_LEN) >
+        raw_tx_len_except_bip44) {
+        return false;
+    }
+
+    // the fee is the GAS the outputs leave out of the inputs, it is only known when every input is
+    // attested. otherwise GAS inputs the outputs leave out would be burnt without a review.
+    if (!tx_summary.fee_known) {
+        return false;
+    }
+    uint64_t tx_value = 0;
+    if (policy.asset_label == ASSET_LABEL_GAS) {
+        if (tx_summary.fee > policy.max_tx_value) {
+            return false;
+        }
+        tx_value = tx_summary.fee;
+    } else if (tx_summary.fee != 0) {
+        return false;
+    }
+
+    const unsigned char *tx_out = raw_tx + tx_summary.tx_outs_ix;
+    for (unsigned char out_ix = 0; out_ix < tx_summary.num_tx_outs; out_ix++) {
+        const unsigned char *asset_id = tx_out;
+        const unsigned char *value = asset_id + ASSET_ID_LEN;
+        const unsigned char *script_hash = value + VALUE_LEN;
+        tx_out += TX_OUTPUT_LEN;
+
+        if (get_asset_label(asset_id) != policy.asset_label) {
+            return false;
+        }
+
+        if (memcmp(script_hash, policy.change_script_hash, SCRIPT_HASH_LEN) == 0) {
+            continue;
+        }
+        if (!is_policy_destination(script_hash)) {
+            return false;
+        }
+
+        // compare against what is left of the cap, so the sum can not overflow.
+        uint64_t out_value = value_to_uint64(value);
+        if (out_value > policy.max_tx_value - tx_value) {
+            return false;
+        }
+        tx_value += out_value;
+    }
+
+    if (tx_value > policy.max_total_value - policy.total_value) {
+        return false;
+    }
+
+    policy.total_value += tx_value;
+    policy.tx_count_left--;
+    return true;
+}
+
+/** forget the policy. */
+void policy_clear(void) {
+    explicit_bzero(&policy, sizeof(policy));
+}
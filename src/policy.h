@@ -0,0 +1,93 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "ui.h"
+#include "neo.h"
+
+/** for the spending policy, asks for the review of the policy in the message. */
+#define P1_POLICY_SET 0x00
+
+/** for the spending policy, drops the current policy, no review needed. */
+#define P1_POLICY_CLEAR 0x01
+
+/** asset mask of a policy allowing NEO outputs. a policy allows a single asset, so that its caps
+ * are amounts of that asset. */
+#define POLICY_ASSET_NEO 0x01
+
+/** asset mask of a policy allowing GAS outputs. */
+#define POLICY_ASSET_GAS 0x02
+
+/** max number of destinations a policy allows. */
+#define MAX_POLICY_DESTINATIONS 3
+
+/** number of tx_desc screens of a policy review: the asset, the three caps, the account and the
+ * destinations. */
+#define MAX_POLICY_SCREENS (5 + MAX_POLICY_DESTINATIONS)
+
+/** length of a policy message without its destinations: <asset mask> <max tx value> <max total
+ * value> <max tx count> <destination count> <bip44 path> */
+#define POLICY_FIXED_LEN (1 + VALUE_LEN + VALUE_LEN + 1 + 1 + BIP44_BYTE_LENGTH)
+
+/** a spending policy, under which transactions are signed without review. */
+typedef struct {
+    /** true once the user has approved the policy. */
+    bool active;
+
+    /** the label of the only asset that can be sent, NEO or GAS. */
+    unsigned char asset_label;
+
+    /** max value of the asset sent by a single transaction, change excluded, the fee included
+     * under a GAS policy. */
+    uint64_t max_tx_value;
+
+    /** max value of the asset sent by all the transactions signed under the policy, fees
+     * included. */
+    uint64_t max_total_value;
+
+    /** value sent so far under the policy. */
+    uint64_t total_value;
+
+    /** number of transactions that can still be signed under the policy. */
+    unsigned char tx_count_left;
+
+    /** the script hashes the transactions can send to. */
+    unsigned char destinations[MAX_POLICY_DESTINATIONS][SCRIPT_HASH_LEN];
+
+    /** number of script hashes in destinations. */
+    unsigned char destination_count;
+
+    /** the BIP44 path of the only key signing under the policy, as received. */
+    unsigned char bip44_path[BIP44_BYTE_LENGTH];
+
+    /** the script hash of that key, outputs back to it are change. */
+    unsigned char change_script_hash[SCRIPT_HASH_LEN];
+} policy_t;
+
+/** the policy of the session. */
+extern policy_t policy;
+
+/** read a policy message of len bytes, it is held until the user approves it. returns the status
+ * word. */
+unsigned short policy_set(const unsigned char *in, unsigned int len);
+
+/** fill the tx_desc screens with the pending policy, returns the status word. */
+unsigned short policy_display_desc(void);
+
+/** the user approved the pending policy. */
+void policy_approve(void);
+
+/** true if the transaction just parsed from raw_tx can be signed under the policy, in which case
+ * it is counted against the policy. its inputs must be attested, so that its fee is known. */
+bool policy_consume_tx(void);
+
+/** forget the policy. */
+void policy_clear(void);
+
+#endif  // POLICY_H
@@ -0,0 +1,53 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include "sig_cache.h"
+
+/** the signatures kept for retries, in RAM only. */
+static sig_cache_entry_t sig_cache[SIG_CACHE_SIZE];
+
+/** index of the entry the next signature goes to, the oldest one once the cache is full. */
+static unsigned char sig_cache_next_ix;
+
+/** keep the signature of hash by the key at bip44_path, replacing the oldest entry if needed. a
+ * signature that does not fit an entry is not kept. */
+void sig_cache_add(const unsigned char *hash,
+                   const unsigned char *bip44_path,
+                   const unsigned char *sig,
+                   unsigned int sig_len) {
+    if ((sig_len == 0) || (sig_len > MAX_DER_SIG_LEN)) {
+        return;
+    }
+
+    // RFC6979 signatures are deterministic, so a cached transaction never needs a second entry.
+    unsigned char out[MAX_DER_SIG_LEN];
+    if (sig_cache_get(hash, bip44_path, out) != 0) {
+        return;
+    }
+
+    sig_cache_entry_t *entry = &sig_cache[sig_cache_next_ix];
+    memmove(entry->hash, hash, sizeof(entry->hash));
+    memmove(entry->bip44_path, bip44_path, sizeof(entry->bip44_path));
+    memmove(entry->sig, sig, sig_len);
+    entry->sig_len = sig_len;
+
+    sig_cache_next_ix = (sig_cache_next_ix + 1) % SIG_CACHE_SIZE;
+}
+
+/** copy the cached signature of hash by the key at bip44_path to out, returns its length, or zero
+ * if it is not cached. */
+unsigned int sig_cache_get(const unsigned char *hash,
+                           const unsigned char *bip44_path,
+                           unsigned char *out) {
+    for (unsigned char ix = 0; ix < SIG_CACHE_SIZE; ix++) {
+        const sig_cache_entry_t *entry = &sig_cache[ix];
+        if ((entry->sig_len != 0) && (memcmp(entry->hash, hash, sizeof(entry->hash)) == 0) &&
+            (memcmp(entry->bip44_path, bip44_path, sizeof(entry->bip44_path)) == 0)) {
+            memmove(out, entry->sig, entry->sig_len);
+            return entry->sig_len;
+        }
+    }
+    return 0;
+}
+
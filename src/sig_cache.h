@@ -0,0 +1,47 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef SIG_CACHE_H
+#define SIG_CACHE_H
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "ui.h"
+
+/** number of signatures kept for retries, fewer on the Nano S to save RAM. */
+#if defined(TARGET_NANOS)
+#define SIG_CACHE_SIZE 2
+#else
+#define SIG_CACHE_SIZE 4
+#endif
+
+/** a signature the user approved, with what it signs. */
+typedef struct {
+    /** the final hash of the transaction. */
+    unsigned char hash[CX_SHA256_SIZE];
+
+    /** the BIP44 path of the signing key, as received. */
+    unsigned char bip44_path[BIP44_BYTE_LENGTH];
+
+    /** the DER signature. */
+    unsigned char sig[MAX_DER_SIG_LEN];
+
+    /** length of sig, zero if the entry is empty. */
+    unsigned char sig_len;
+} sig_cache_entry_t;
+
+/** keep the signature of hash by the key at bip44_path, replacing the oldest entry if needed. */
+void sig_cache_add(const unsigned char *hash,
+                   const unsigned char *bip44_path,
+                   const unsigned char *sig,
+                   unsigned int sig_len);
+
+/** copy the cached signature of hash by the key at bip44_path to out, returns its length, or zero
+ * if it is not cached. */
+unsigned int sig_cache_get(const unsigned char *hash,
+                           const unsigned char *bip44_path,
+                           unsigned char *out);
+
+#endif  // SIG_CACHE_H
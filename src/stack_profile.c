@@ -0,0 +1,62 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifdef HAVE_STACK_PROFILE
+
+#include "stack_profile.h"
+
+/** the byte the unused stack is painted with. */
+#define STACK_PAINT 0xA5
+
+/** the bytes left unpainted below the painting frame, for the loop itself. */
+#define STACK_PAINT_MARGIN 32
+
+/** the no slot value, before the first instruction. */
+#define STACK_PROFILE_NO_SLOT 0xFF
+
+/** the bottom and the top of the stack, from the linker script. the stack grows down. */
+extern unsigned long _stack;
+extern unsigned long _estack;
+
+/** the most stack each instruction used, in bytes, by its slot. */
+unsigned short stack_peak[STACK_PROFILE_SLOTS];
+
+/** the slot of the instruction the stack is charged to. */
+static unsigned char stack_slot = STACK_PROFILE_NO_SLOT;
+
+unsigned short stack_profile_size(void) {
+    return (unsigned char *) &_estack - (unsigned char *) &_stack;
+}
+
+void stack_profile_begin(unsigned char slot) {
+    volatile unsigned char here;
+    unsigned char *paint = (unsigned char *) &_stack;
+    unsigned char *paint_end = (unsigned char *) &here - STACK_PAINT_MARGIN;
+    while (paint < paint_end) {
+        *paint++ = STACK_PAINT;
+    }
+    stack_slot = (slot < STACK_PROFILE_SLOTS) ? slot : STACK_PROFILE_NO_SLOT;
+}
+
+void stack_profile_end(void) {
+    if (stack_slot == STACK_PROFILE_NO_SLOT) {
+        return;
+    }
+    // the first byte that is not paint is the deepest the stack went.
+    const unsigned char *deepest = (const unsigned char *) &_stack;
+    while ((deepest < (const unsigned char *) &_estack) && (*deepest == STACK_PAINT)) {
+        deepest++;
+    }
+    unsigned short used = (const unsigned char *) &_estack - deepest;
+    if (used > stack_peak[stack_slot]) {
+        stack_peak[stack_slot] = used;
+    }
+    stack_slot = STACK_PROFILE_NO_SLOT;
+}
+
+void stack_profile_reset(void) {
+    memset(stack_peak, 0, sizeof(stack_peak));
+}
+
+#endif  // HAVE_STACK_PROFILE
@@ -0,0 +1,37 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef STACK_PROFILE_H
+#define STACK_PROFILE_H
+
+#ifdef HAVE_STACK_PROFILE
+
+#include "os.h"
+#include <stdbool.h>
+
+/** the most instructions whose stack high-water mark is kept. */
+#define STACK_PROFILE_SLOTS 16
+
+/** for INS_GET_STACK_PROFILE, clears the high-water marks once they are sent. */
+#define P1_STACK_PROFILE_RESET 0x01
+
+/** the most stack each instruction used, in bytes, by its slot. */
+extern unsigned short stack_peak[STACK_PROFILE_SLOTS];
+
+/** the size of the stack, in bytes. */
+unsigned short stack_profile_size(void);
+
+/** paint the unused stack, and charge what is used from now on to the instruction in slot. */
+void stack_profile_begin(unsigned char slot);
+
+/** charge the most stack used since stack_profile_begin to its instruction. the profile runs until
+ * the next APDU, so it holds the review and the signing that follow an instruction. */
+void stack_profile_end(void);
+
+/** clear the high-water marks. */
+void stack_profile_reset(void);
+
+#endif  // HAVE_STACK_PROFILE
+
+#endif  // STACK_PROFILE_H
@@ -0,0 +1,17 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifdef HAVE_STAGE_PROFILE
+
+#include "stage_profile.h"
+
+/** the counters of the stages, by stage. */
+stage_counter_t stage_counters[STAGE_PROFILE_STAGES];
+
+void stage_profile_count(enum STAGE stage, unsigned int bytes) {
+    stage_counters[stage].calls++;
+    stage_counters[stage].bytes += bytes;
+}
+
+#endif  // HAVE_STAGE_PROFILE
@@ -0,0 +1,52 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef STAGE_PROFILE_H
+#define STAGE_PROFILE_H
+
+/** the stages of signing that are profiled. */
+enum STAGE {
+    /** parsing raw_tx into the review, in display_tx_desc. the bytes are the transaction's. */
+    STAGE_PARSE,
+    /** the SHA-256 checksum of an address, in to_address. the bytes are the ones hashed. */
+    STAGE_ADDRESS_HASH,
+    /** base58 and base10 encoding. the bytes are the ones encoded. */
+    STAGE_BASE_X,
+    /** BIP32 key derivation. */
+    STAGE_DERIVE,
+    /** ECDSA signing. the bytes are the ones signed. */
+    STAGE_SIGN,
+    /** showing a review. the bytes are its screens. */
+    STAGE_REVIEW,
+    /** the number of stages. */
+    STAGE_PROFILE_STAGES
+};
+
+#ifdef HAVE_STAGE_PROFILE
+
+#include "os.h"
+
+/** the calls of a stage, and the bytes they worked on. */
+typedef struct {
+    unsigned int calls;
+    unsigned int bytes;
+} stage_counter_t;
+
+/** the counters of the stages, by stage. */
+extern stage_counter_t stage_counters[STAGE_PROFILE_STAGES];
+
+/** count a call of the stage, working on bytes. */
+void stage_profile_count(enum STAGE stage, unsigned int bytes);
+
+/** count a call of the stage, working on bytes. nothing outside of STAGE_PROFILE builds. */
+#define PROFILE_STAGE(stage, bytes) stage_profile_count(stage, bytes)
+
+#else
+
+/** count a call of the stage, working on bytes. nothing outside of STAGE_PROFILE builds. */
+#define PROFILE_STAGE(stage, bytes)
+
+#endif  // HAVE_STAGE_PROFILE
+
+#endif  // STAGE_PROFILE_H
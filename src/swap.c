@@ -0,0 +1,251 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifdef HAVE_SWAP
+
+#include "swap.h"
+#include "crypto_helpers.h"
+#include "stage_profile.h"
+
+/** the Exchange app's id for its calls. */
+#define SWAP_LIBARGS_ID 0x100
+
+/** the payout of the swap. */
+swap_t swap;
+
+/** returns the label of the asset of the coin configuration, which is its ticker. the app's own
+ * coin, NEO, has no configuration. */
+static enum ASSET_LABEL get_swap_asset_label(const unsigned char *config, unsigned char len) {
+    if (len == 0) {
+        return ASSET_LABEL_NEO;
+    }
+    if ((len == 3) && (memcmp(config, "NEO", 3) == 0)) {
+        return ASSET_LABEL_NEO;
+    }
+    if ((len == 3) && (memcmp(config, "GAS", 3) == 0)) {
+        return ASSET_LABEL_GAS;
+    }
+    return ASSET_LABEL_UNKNOWN;
+}
+
+/** reads a big endian amount of len bytes, false if it does not fit in 64 bits. */
+static bool amount_to_uint64(const unsigned char *amount, unsigned char len, uint64_t *out) {
+    *out = 0;
+    for (unsigned char ix = 0; ix < len; ix++) {
+        if ((*out >> 56) != 0) {
+            return false;
+        }
+        *out = (*out << 8) | amount[ix];
+    }
+    return true;
+}
+
+/** writes the script hash of the key at the BIP44 path, as received, false if it can not be
+ * derived. */
+static bool bip44_path_to_script_hash(const unsigned char *bip44_in, unsigned char *script_hash) {
+    unsigned int bip44_path[BIP44_PATH_LEN];
+    for (uint32_t i = 0; i < BIP44_PATH_LEN; i++) {
+        bip44_path[i] =
+            (bip44_in[0] << 24) | (bip44_in[1] << 16) | (bip44_in[2] << 8) | (bip44_in[3]);
+        bip44_in += 4;
+    }
+
+    uint8_t raw_pubkey[65];
+    PROFILE_STAGE(STAGE_DERIVE, 0);
+    if (bip32_derive_get_pubkey_256(CX_CURVE_256R1,
+                                    bip44_path,
+                                    BIP44_PATH_LEN,
+                                    raw_pubkey,
+                                    NULL,
+                                    CX_SHA512) != CX_OK) {
+        return false;
+    }
+    public_key_to_script_hash(raw_pubkey, script_hash);
+    return true;
+}
+
+/** check that the address to check is the one of the key at the path of the address parameters:
+ * <path length> <bip44 path>. nothing is shown, the Exchange app shows the address itself. */
+static void swap_check_address(check_address_parameters_t *params) {
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    char address[ADDRESS_BASE58_LEN + 1];
+
+    params->result = 0;
+    if ((params->address_parameters == NULL) || (params->address_to_check == NULL) ||
+        (params->address_parameters_length != 1 + BIP44_BYTE_LENGTH) ||
+        (params->address_parameters[0] != BIP44_PATH_LEN)) {
+        return;
+    }
+    if (!bip44_path_to_script_hash(params->address_parameters + 1, script_hash)) {
+        return;
+    }
+
+    memset(address, '\0', sizeof(address));
+    if (to_address(address, sizeof(address), script_hash) != SW_OK) {
+        return;
+    }
+    if (strncmp(address, params->address_to_check, sizeof(address)) == 0) {
+        params->result = 1;
+    }
+}
+
+/** write an amount as the review shows it, the ticker then the value. fees are in GAS. */
+static void swap_get_printable_amount(get_printable_amount_parameters_t *params) {
+    unsigned char value[VALUE_LEN];
+    char value_base10[VALUE_BASE10_LEN];
+    uint64_t amount;
+
+    memset(params->printable_amount, '\0', sizeof(params->printable_amount));
+
+    enum ASSET_LABEL asset_label = ASSET_LABEL_GAS;
+    if (!params->is_fee) {
+        asset_label =
+            get_swap_asset_label(params->coin_configuration, params->coin_configuration_length);
+    }
+    if ((asset_label == ASSET_LABEL_UNKNOWN) ||
+        !amount_to_uint64(params->amount, params->amount_length, &amount)) {
+        return;
+    }
+
+    uint64_to_value(value, amount);
+    memset(value_base10, '\0', sizeof(value_base10));
+    if (to_base10_100m(value_base10, value, sizeof(value_base10)) != SW_OK) {
+        return;
+    }
+    // an amount cut short is not shown.
+    if (snprintf(params->printable_amount,
+                 sizeof(params->printable_amount),
+                 "%s %s",
+                 (asset_label == ASSET_LABEL_NEO) ? "NEO" : "GAS",
+                 value_base10) >= (int) sizeof(params->printable_amount)) {
+        memset(params->printable_amount, '\0', sizeof(params->printable_amount));
+    }
+}
+
+/** keep the payout the Exchange app agreed on, false if it can not be paid out by the app. */
+static bool swap_copy_transaction_parameters(create_transaction_parameters_t *params) {
+    memset(&swap, 0, sizeof(swap));
+    // the payout is not signed until swap_sign_tx_and_exit signs it.
+    params->result = 0;
+
+    if (params->destination_address == NULL) {
+        return false;
+    }
+    // the address must fit with its terminating null, so the copy is complete.
+    size_t destination_len = strnlen(params->destination_address, sizeof(swap.destination));
+    if ((destination_len == 0) || (destination_len == sizeof(swap.destination))) {
+        return false;
+    }
+    memmove(swap.destination, params->destination_address, destination_len);
+
+    swap.asset_label =
+        get_swap_asset_label(params->coin_configuration, params->coin_configuration_length);
+    if ((swap.asset_label == ASSET_LABEL_UNKNOWN) ||
+        !amount_to_uint64(params->amount, params->amount_length, &swap.amount) ||
+        !amount_to_uint64(params->fee_amount, params->fee_amount_length, &swap.fee)) {
+        memset(&swap, 0, sizeof(swap));
+        return false;
+    }
+
+    swap.params = params;
+    swap.active = true;
+    return true;
+}
+
+/** handle a call of the Exchange app. returns true if the app has to run to sign the payout,
+ * otherwise the call is done and the app returns to the Exchange app. */
+bool swap_library_main(libargs_t *args) {
+    if (args->id != SWAP_LIBARGS_ID) {
+        return false;
+    }
+    switch (args->command) {
+        case CHECK_ADDRESS:
+            swap_check_address(args->check_address);
+            return false;
+
+        case GET_PRINTABLE_AMOUNT:
+            swap_get_printable_amount(args->get_printable_amount);
+            return false;
+
+        case SIGN_TRANSACTION:
+            return swap_copy_transaction_parameters(args->create_transaction);
+
+        default:
+            return false;
+    }
+}
+
+/** true if the transaction just parsed from raw_tx is the payout. it must be a contract
+ * transaction with the agreed fee, signed with a single key. one output pays the agreed amount of
+ * the agreed asset to the destination, the others go back to the key as change. */
+static bool swap_check_tx(void) {
+    if ((tx_summary.tx_type != TX_CONTRACT) || (!tx_summary.fee_known) ||
+        (tx_summary.fee != swap.fee)) {
+        return false;
+    }
+    if ((signing_ctx.key_count != 1) || signing_ctx.multi_sign ||
+        (raw_tx_len < BIP44_BYTE_LENGTH)) {
+        return false;
+    }
+
+    // display_tx_desc read the outputs, only check that they end before the BIP44 path.
+    unsigned int raw_tx_len_except_bip44 = raw_tx_len - BIP44_BYTE_LENGTH;
+    if (tx_summary.tx_outs_ix + (tx_summary.num_tx_outs * (unsigned int) TX_OUTPUT_LEN) >
+        raw_tx_len_except_bip44) {
+        return false;
+    }
+
+    unsigned char change_script_hash[SCRIPT_HASH_LEN];
+    if (!bip44_path_to_script_hash(signing_ctx.bip44_path, change_script_hash)) {
+        return false;
+    }
+
+    unsigned char payout_count = 0;
+    const unsigned char *tx_out = raw_tx + tx_summary.tx_outs_ix;
+    for (unsigned char out_ix = 0; out_ix < tx_summary.num_tx_outs; out_ix++) {
+        const unsigned char *asset_id = tx_out;
+        const unsigned char *value = asset_id + ASSET_ID_LEN;
+        const unsigned char *script_hash = value + VALUE_LEN;
+        tx_out += TX_OUTPUT_LEN;
+
+        enum ASSET_LABEL asset_label = get_asset_label(asset_id);
+        if (asset_label == ASSET_LABEL_UNKNOWN) {
+            return false;
+        }
+        if (memcmp(script_hash, change_script_hash, SCRIPT_HASH_LEN) == 0) {
+            continue;
+        }
+
+        char address[ADDRESS_BASE58_LEN + 1];
+        memset(address, '\0', sizeof(address));
+        if (to_address(address, sizeof(address), script_hash) != SW_OK) {
+            return false;
+        }
+        if ((strncmp(address, swap.destination, sizeof(address)) != 0) ||
+            (asset_label != swap.asset_label) || (value_to_uint64(value) != swap.amount)) {
+            return false;
+        }
+        payout_count++;
+    }
+    return payout_count == 1;
+}
+
+/** sign the transaction just parsed from raw_tx if it is the payout, send the response and return
+ * to the Exchange app. the payout is not reviewed, the user approved the swap in the Exchange app.
+ */
+void swap_sign_tx_and_exit(void) {
+    bool signed_payout = false;
+    if (swap_check_tx()) {
+        signed_payout = (sign_tx_and_send() == SW_OK);
+    } else {
+        clear_signing_context();
+        session_end();
+        io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, append_status_word(0, 0x6D1D));
+    }
+    swap.params->result = signed_payout ? 1 : 0;
+    swap.active = false;
+    os_lib_end();
+}
+
+#endif  // HAVE_SWAP
@@ -0,0 +1,52 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#ifndef SWAP_H
+#define SWAP_H
+
+#ifdef HAVE_SWAP
+
+#include "os.h"
+#include "cx.h"
+#include <stdbool.h>
+#include "swap_lib_calls.h"
+#include "ui.h"
+#include "neo.h"
+
+/** the payout the Exchange app agreed on, the only transaction signed while it runs the app. */
+typedef struct {
+    /** true when the app runs for the Exchange app to sign the payout. */
+    bool active;
+
+    /** the label of the asset paid out, NEO or GAS. */
+    unsigned char asset_label;
+
+    /** the value paid out. */
+    uint64_t amount;
+
+    /** the fee of the payout transaction. */
+    uint64_t fee;
+
+    /** the address the payout goes to. */
+    char destination[ADDRESS_BASE58_LEN + 1];
+
+    /** the Exchange app's parameters of the payout, their result tells it if the payout was
+     * signed. */
+    create_transaction_parameters_t *params;
+} swap_t;
+
+/** the payout of the swap. */
+extern swap_t swap;
+
+/** handle a call of the Exchange app. returns true if the app has to run to sign the payout,
+ * otherwise the call is done and the app returns to the Exchange app. */
+bool swap_library_main(libargs_t *args);
+
+/** sign the transaction just parsed from raw_tx if it is the payout, send the response and return
+ * to the Exchange app, with the result of the payout set. */
+void swap_sign_tx_and_exit(void);
+
+#endif  // HAVE_SWAP
+
+#endif  // SWAP_H
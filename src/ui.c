@@ -5,6 +5,10 @@
 #include "ui.h"
 #include "glyphs.h"
 #include "crypto_helpers.h"
+#include "batch.h"
+#include "policy.h"
+#include "sig_cache.h"
+#include "stage_profile.h"
 
 /** default font */
 #define DEFAULT_FONT BAGL_FONT_OPEN_SANS_EXTRABOLD_11px | BAGL_FONT_ALIGNMENT_CENTER
@@ -60,15 +64,9 @@ bolos_ux_params_t G_ux_params;
 
 #endif
 
-/** notification to restart the hash */
-unsigned char hashTainted;
-
 /** notification to refresh the view, if we are displaying the public key */
 unsigned char publicKeyNeedsRefresh;
 
-/** the hash. */
-cx_sha256_t tx_hash;
-
 /** index of the current screen. */
 unsigned int curr_scr_ix;
 
@@ -84,18 +82,47 @@ unsigned int raw_tx_ix;
 /** current length of raw transaction. */
 unsigned int raw_tx_len;
 
+/** the signing session. */
+session_t session;
+
 /** all text descriptions. */
 char tx_desc[MAX_TX_TEXT_SCREENS][MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
 
+#ifdef HAVE_BAGL
 /** currently displayed text description. */
 char curr_tx_desc[MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
+#endif
 
 /** currently displayed address */
-char address58[MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
+char address58[ADDRESS58_LINES][MAX_TX_TEXT_WIDTH];
+
+/** the signing context for the transaction under review. */
+signing_context_t signing_ctx;
+
+/** the format of the signature responses, SIGN_FORMAT_* flags. */
+unsigned char sign_format;
 
 /** UI was touched indicating the user wants to deny te signature request */
 static const void *reject_tx_and_send_response(void);
 
+/** UI was touched indicating the user approves all the transactions of the batch */
+static const void *approve_batch_and_send_response(void);
+
+/** UI was touched indicating the user denies all the transactions of the batch */
+static const void *reject_batch_and_send_response(void);
+
+/** UI was touched indicating the user approves the spending policy */
+static const void *approve_policy_and_send_response(void);
+
+/** UI was touched indicating the user denies the spending policy */
+static const void *reject_policy_and_send_response(void);
+
+/** title of the batch review, which gives the number of transactions */
+static char batch_title[MAX_TX_TEXT_WIDTH];
+
+/** how much of the transaction arrived, shown while it uploads */
+static char progress_text[MAX_TX_TEXT_WIDTH];
+
 /** sets the tx_desc variables to no information */
 static void clear_tx_desc(void);
 
@@ -136,6 +163,44 @@ UX_FLOW(ux_confirm_single_flow,
         &ux_confirm_single_flow_5_step,
         &ux_confirm_single_flow_6_step);
 
+// the inputs and fee screens move with the number of outputs, copy them before display.
+UX_STEP_NOCB_INIT(ux_confirm_fee_flow_inputs_step,
+                  bnn,
+                  memmove(curr_tx_desc, tx_desc[tx_summary.inputs_scr_ix], CURR_TX_DESC_LEN),
+                  {
+                      curr_tx_desc[0],
+                      curr_tx_desc[1],
+                      curr_tx_desc[2],
+                  });
+UX_STEP_NOCB_INIT(ux_confirm_fee_flow_inputs_gas_step,
+                  bnn,
+                  memmove(curr_tx_desc, tx_desc[tx_summary.inputs_scr_ix + 1], CURR_TX_DESC_LEN),
+                  {
+                      curr_tx_desc[0],
+                      curr_tx_desc[1],
+                      curr_tx_desc[2],
+                  });
+UX_STEP_NOCB_INIT(ux_confirm_fee_flow_fee_step,
+                  bnn,
+                  memmove(curr_tx_desc,
+                          tx_desc[tx_summary.inputs_scr_ix + INPUTS_SCREENS],
+                          CURR_TX_DESC_LEN),
+                  {
+                      curr_tx_desc[0],
+                      curr_tx_desc[1],
+                      curr_tx_desc[2],
+                  });
+UX_FLOW(ux_confirm_fee_flow,
+        &ux_confirm_single_flow_1_step,
+        &ux_confirm_single_flow_2_step,
+        &ux_confirm_single_flow_3_step,
+        &ux_confirm_single_flow_4_step,
+        &ux_confirm_fee_flow_inputs_step,
+        &ux_confirm_fee_flow_inputs_gas_step,
+        &ux_confirm_fee_flow_fee_step,
+        &ux_confirm_single_flow_5_step,
+        &ux_confirm_single_flow_6_step);
+
 UX_STEP_NOCB(ux_display_public_flow_step,
              bnnn,
              {"Address", address58[0], address58[1], address58[2]});
@@ -149,6 +214,106 @@ UX_STEP_VALID(ux_display_public_go_back_step,
 
 UX_FLOW(ux_display_public_flow, &ux_display_public_flow_step, &ux_display_public_go_back_step);
 
+UX_STEP_NOCB(ux_batch_flow_intro_step, pnn, {&C_icon_eye, "Review", batch_title});
+
+/** the two steps of the transaction at batch_ix in the batch review, see display_batch_tx_desc */
+#define UX_BATCH_TX_STEPS(batch_ix)                                           \
+    UX_STEP_NOCB(ux_batch_flow_tx_##batch_ix##_step,                          \
+                 bnn,                                                         \
+                 {                                                            \
+                     tx_desc[2 * batch_ix][0],                                \
+                     tx_desc[2 * batch_ix][1],                                \
+                     tx_desc[2 * batch_ix][2],                                \
+                 });                                                          \
+    UX_STEP_NOCB(ux_batch_flow_address_##batch_ix##_step,                     \
+                 bnnn,                                                        \
+                 {"Destination Address",                                      \
+                  tx_desc[2 * batch_ix + 1][0],                               \
+                  tx_desc[2 * batch_ix + 1][1],                               \
+                  tx_desc[2 * batch_ix + 1][2]});
+
+UX_BATCH_TX_STEPS(0)
+UX_BATCH_TX_STEPS(1)
+UX_BATCH_TX_STEPS(2)
+UX_BATCH_TX_STEPS(3)
+
+UX_STEP_VALID(ux_batch_flow_accept_step,
+              pb,
+              approve_batch_and_send_response(),
+              {
+                  &C_icon_validate_14,
+                  "Accept all",
+              });
+UX_STEP_VALID(ux_batch_flow_reject_step,
+              pb,
+              reject_batch_and_send_response(),
+              {
+                  &C_icon_crossmark,
+                  "Reject all",
+              });
+
+/** the steps of each transaction of the batch review, the flow is built from the batch size */
+static const ux_flow_step_t *const ux_batch_tx_steps[MAX_BATCH_TXS][2] = {
+    {&ux_batch_flow_tx_0_step, &ux_batch_flow_address_0_step},
+    {&ux_batch_flow_tx_1_step, &ux_batch_flow_address_1_step},
+    {&ux_batch_flow_tx_2_step, &ux_batch_flow_address_2_step},
+    {&ux_batch_flow_tx_3_step, &ux_batch_flow_address_3_step},
+};
+
+/** the batch review flow: intro, two steps per transaction, accept, reject and the end marker */
+static const ux_flow_step_t *ux_batch_flow[1 + (2 * MAX_BATCH_TXS) + 2 + 1];
+
+UX_STEP_NOCB(ux_policy_flow_intro_step, pnn, {&C_icon_eye, "Review", "Spending Policy"});
+
+/** the step of the screen at scr_ix in the policy review, see policy_display_desc */
+#define UX_POLICY_STEP(scr_ix)                     \
+    UX_STEP_NOCB(ux_policy_flow_##scr_ix##_step,   \
+                 bnn,                              \
+                 {                                 \
+                     tx_desc[scr_ix][0],           \
+                     tx_desc[scr_ix][1],           \
+                     tx_desc[scr_ix][2],           \
+                 });
+
+UX_POLICY_STEP(0)
+UX_POLICY_STEP(1)
+UX_POLICY_STEP(2)
+UX_POLICY_STEP(3)
+UX_POLICY_STEP(4)
+UX_POLICY_STEP(5)
+UX_POLICY_STEP(6)
+UX_POLICY_STEP(7)
+
+UX_STEP_VALID(ux_policy_flow_accept_step,
+              pb,
+              approve_policy_and_send_response(),
+              {
+                  &C_icon_validate_14,
+                  "Accept policy",
+              });
+UX_STEP_VALID(ux_policy_flow_reject_step,
+              pb,
+              reject_policy_and_send_response(),
+              {
+                  &C_icon_crossmark,
+                  "Reject policy",
+              });
+
+/** the step of each screen of the policy review, the flow is built from the number of screens */
+static const ux_flow_step_t *const ux_policy_steps[MAX_POLICY_SCREENS] = {
+    &ux_policy_flow_0_step,
+    &ux_policy_flow_1_step,
+    &ux_policy_flow_2_step,
+    &ux_policy_flow_3_step,
+    &ux_policy_flow_4_step,
+    &ux_policy_flow_5_step,
+    &ux_policy_flow_6_step,
+    &ux_policy_flow_7_step,
+};
+
+/** the policy review flow: intro, one step per screen, accept, reject and the end marker */
+static const ux_flow_step_t *ux_policy_flow[1 + MAX_POLICY_SCREENS + 2 + 1];
+
 void display_account_address() {
     if (G_ux.stack_count == 0) {
         ux_stack_push();
@@ -186,11 +351,39 @@ UX_FLOW(ux_idle_flow,
         &ux_idle_flow_3_step,
         &ux_idle_flow_4_step);
 
+UX_STEP_NOCB(ux_progress_flow_step, nn, {"Receiving", progress_text});
+UX_FLOW(ux_progress_flow, &ux_progress_flow_step);
+
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////  NANO S //////////////////////////////////////////////////
 #if defined(TARGET_NANOS)
+/** what the Nano S review screens ask the user to approve */
+static enum { REVIEW_TX, REVIEW_BATCH, REVIEW_POLICY } reviewKind = REVIEW_TX;
+
+/** approve what is under review */
+static void approve_review(void) {
+    if (reviewKind == REVIEW_BATCH) {
+        approve_batch_and_send_response();
+    } else if (reviewKind == REVIEW_POLICY) {
+        approve_policy_and_send_response();
+    } else {
+        sign_tx_and_send_response();
+    }
+}
+
+/** deny what is under review */
+static void reject_review(void) {
+    if (reviewKind == REVIEW_BATCH) {
+        reject_batch_and_send_response();
+    } else if (reviewKind == REVIEW_POLICY) {
+        reject_policy_and_send_response();
+    } else {
+        reject_tx_and_send_response();
+    }
+}
+
 /** UI struct for the idle screen */
 static const bagl_element_t bagl_ui_idle_nanos[] = {
     // { {type, userid, x, y, width, height, stroke, radius, fill, fgcolor, bgcolor, font_id,
@@ -310,6 +503,34 @@ static unsigned int bagl_ui_public_key_nanos_2_button(unsigned int button_mask,
     return 0;
 }
 
+/** UI struct for the upload progress screen, Nano S. */
+static const bagl_element_t bagl_ui_progress_nanos[] = {
+    // { {type, userid, x, y, width, height, stroke, radius, fill, fgcolor, bgcolor, font_id,
+    // icon_id},
+    // text, touch_area_brim, overfgcolor, overbgcolor, tap, out, over,
+    // },
+    {{BAGL_RECTANGLE, 0x00, 0, 0, 128, 32, 0, 0, BAGL_FILL, 0x000000, 0xFFFFFF, 0, 0}, NULL},
+    /* first line */
+    {{BAGL_LABELINE, 0x02, 0, 12, 128, 11, 0, 0, 0, 0xFFFFFF, 0x000000, DEFAULT_FONT, 0},
+     "Receiving"},
+    /* second line, how much arrived */
+    {{BAGL_LABELINE, 0x02, 0, 26, 128, 11, 0, 0, 0, 0xFFFFFF, 0x000000, DEFAULT_FONT, 0},
+     progress_text},
+    /* */
+};
+
+/**
+ * buttons for the upload progress screen
+ *
+ * the buttons do nothing, the review follows once the transaction arrived.
+ */
+static unsigned int bagl_ui_progress_nanos_button(unsigned int button_mask,
+                                                  unsigned int button_mask_counter) {
+    UNUSED(button_mask);
+    UNUSED(button_mask_counter);
+    return 0;
+}
+
 /** UI struct for the top "Sign Transaction" screen, Nano S. */
 static const bagl_element_t bagl_ui_top_sign_nanos[] = {
     // { {type, userid, x, y, width, height, stroke, radius, fill, fgcolor, bgcolor, font_id,
@@ -341,7 +562,7 @@ static unsigned int bagl_ui_top_sign_nanos_button(unsigned int button_mask,
     UNUSED(button_mask_counter);
     switch (button_mask) {
         case BUTTON_EVT_RELEASED | BUTTON_LEFT | BUTTON_RIGHT:
-            sign_tx_and_send_response();
+            approve_review();
             break;
 
         case BUTTON_EVT_RELEASED | BUTTON_RIGHT:
@@ -385,7 +606,7 @@ static unsigned int bagl_ui_sign_nanos_button(unsigned int button_mask,
     UNUSED(button_mask_counter);
     switch (button_mask) {
         case BUTTON_EVT_RELEASED | BUTTON_LEFT | BUTTON_RIGHT:
-            sign_tx_and_send_response();
+            approve_review();
             break;
 
         case BUTTON_EVT_RELEASED | BUTTON_RIGHT:
@@ -428,7 +649,7 @@ static unsigned int bagl_ui_deny_nanos_button(unsigned int button_mask,
     UNUSED(button_mask_counter);
     switch (button_mask) {
         case BUTTON_EVT_RELEASED | BUTTON_LEFT | BUTTON_RIGHT:
-            reject_tx_and_send_response();
+            reject_review();
             break;
 
         case BUTTON_EVT_RELEASED | BUTTON_RIGHT:
@@ -577,8 +798,7 @@ static const bagl_element_t *tx_desc_up(const bagl_element_t *e) {
             break;
 
         default:
-            hashTainted = 1;
-            THROW(0x6D02);
+            session_end();
             break;
     }
     return NULL;
@@ -617,8 +837,7 @@ static const bagl_element_t *tx_desc_dn(const bagl_element_t *e) {
             break;
 
         default:
-            hashTainted = 1;
-            THROW(0x6D01);
+            session_end();
             break;
     }
     return NULL;
@@ -684,9 +903,15 @@ void ui_public_key_2(void) {
 static const char *const infoTypes[] = {"Version", "Developer"};
 static const char *const infoContents[] = {APPVERSION, "Ledger"};
 
-static nbgl_contentTagValue_t fields[3];
+static nbgl_contentTagValue_t fields[REVIEW_PAIRS_MAX];
 static nbgl_contentTagValueList_t pairList;
 
+/** three fields per transaction of a batch review, see display_batch_tx_desc */
+static nbgl_contentTagValue_t batchFields[3 * MAX_BATCH_TXS];
+
+/** one field per screen of a policy review, see policy_display_desc */
+static nbgl_contentTagValue_t policyFields[MAX_POLICY_SCREENS];
+
 static void reviewChoice(bool confirm);
 static void reviewStart(void);
 static void pageCallback(int token, uint8_t index);
@@ -731,17 +956,15 @@ static void reviewChoice(bool confirm) {
 }
 
 static void reviewStart(void) {
+    review_pair_t pairs[REVIEW_PAIRS_MAX];
     memset(&fields, 0, sizeof(fields));
 
     pairList.pairs = fields;
-    pairList.nbPairs = 3;
-
-    fields[0].item = "Type";
-    fields[0].value = tx_desc[0][1];
-    fields[1].item = "Amount";
-    fields[1].value = tx_desc[1][2];
-    fields[2].item = "Destination Address";
-    fields[2].value = tx_desc[2][0];
+    pairList.nbPairs = review_pairs(pairs);
+    for (unsigned char pair_ix = 0; pair_ix < pairList.nbPairs; pair_ix++) {
+        fields[pair_ix].item = pairs[pair_ix].item;
+        fields[pair_ix].value = pairs[pair_ix].value;
+    }
 
     nbgl_useCaseReview(TYPE_TRANSACTION,
                        &pairList,
@@ -751,21 +974,307 @@ static void reviewStart(void) {
                        "Sign transaction",
                        reviewChoice);
 }
+
+static void batchReviewChoice(bool confirm) {
+    if (confirm) {
+        approve_batch_and_send_response();
+        nbgl_useCaseReviewStatus(STATUS_TYPE_TRANSACTION_SIGNED, ui_idle);
+    } else {
+        reject_batch_and_send_response();
+        nbgl_useCaseReviewStatus(STATUS_TYPE_TRANSACTION_REJECTED, ui_idle);
+    }
+}
+
+static void batchReviewStart(void) {
+    memset(&batchFields, 0, sizeof(batchFields));
+
+    for (unsigned char batch_ix = 0; batch_ix < batch.count; batch_ix++) {
+        batchFields[3 * batch_ix].item = tx_desc[2 * batch_ix][0];
+        batchFields[3 * batch_ix].value = tx_desc[2 * batch_ix][1];
+        batchFields[3 * batch_ix + 1].item = "Amount";
+        batchFields[3 * batch_ix + 1].value = tx_desc[2 * batch_ix][2];
+        batchFields[3 * batch_ix + 2].item = "Destination Address";
+        batchFields[3 * batch_ix + 2].value = tx_desc[2 * batch_ix + 1][0];
+    }
+
+    pairList.pairs = batchFields;
+    pairList.nbPairs = 3 * batch.count;
+
+    nbgl_useCaseReview(TYPE_TRANSACTION,
+                       &pairList,
+                       &C_icon_64px,
+                       batch_title,
+                       NULL,
+                       "Sign all transactions",
+                       batchReviewChoice);
+}
+
+static void policyReviewChoice(bool confirm) {
+    if (confirm) {
+        approve_policy_and_send_response();
+        nbgl_useCaseReviewStatus(STATUS_TYPE_OPERATION_SIGNED, ui_idle);
+    } else {
+        reject_policy_and_send_response();
+        nbgl_useCaseReviewStatus(STATUS_TYPE_OPERATION_REJECTED, ui_idle);
+    }
+}
+
+static void policyReviewStart(void) {
+    memset(&policyFields, 0, sizeof(policyFields));
+
+    for (unsigned int scr_ix = 0; scr_ix < max_scr_ix; scr_ix++) {
+        policyFields[scr_ix].item = tx_desc[scr_ix][0];
+        policyFields[scr_ix].value = tx_desc[scr_ix][1];
+    }
+
+    pairList.pairs = policyFields;
+    pairList.nbPairs = max_scr_ix;
+
+    nbgl_useCaseReview(TYPE_OPERATION,
+                       &pairList,
+                       &C_icon_64px,
+                       "Review spending policy",
+                       NULL,
+                       "Accept spending policy",
+                       policyReviewChoice);
+}
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+/** converts a DER signature to the 64 byte r||s NEO witnesses use, false if it does not decode. */
+static bool der_to_raw_sig(const unsigned char *der_sig,
+                           unsigned int der_sig_len,
+                           unsigned char *raw_sig) {
+    const uint8_t *r;
+    const uint8_t *s;
+    size_t r_len;
+    size_t s_len;
+    if (cx_ecfp_decode_sig_der(der_sig, der_sig_len, RAW_SIG_LEN / 2, &r, &r_len, &s, &s_len) !=
+        1) {
+        return false;
+    }
+
+    // r and s are big endian, shorter values are padded on the left.
+    memset(raw_sig, 0, RAW_SIG_LEN);
+    memmove(raw_sig + (RAW_SIG_LEN / 2) - r_len, r, r_len);
+    memmove(raw_sig + RAW_SIG_LEN - s_len, s, s_len);
+    return true;
+}
+
+/** write the status word sw after the tx bytes of the response and return the response length.
+ * this is the only place statuses become status words: the 0x6xxx and 0x9xxx ones are sent as they
+ * are, anything else is reported as 0x68xx. */
+unsigned int append_status_word(unsigned int tx, unsigned short sw) {
+    switch (sw & 0xF000) {
+        case 0x6000:
+        case 0x9000:
+            break;
+        default:
+            sw = 0x6800 | (sw & 0x7FF);
+            break;
+    }
+    G_io_apdu_buffer[tx++] = sw >> 8;
+    G_io_apdu_buffer[tx++] = sw;
+    return tx;
+}
+
+/** fails the signature if the next len bytes of the response do not fit the APDU buffer. */
+static unsigned short check_response_space(unsigned int tx, unsigned int len) {
+    // keep room for the status word.
+    if (tx + len + 2 > sizeof(G_io_apdu_buffer)) {
+        return 0x6D19;
+    }
+    return SW_OK;
+}
+
+/** add the signature of the key at key_ix to the response in sign_format, followed by its witness
+ * if asked for. tx is the response length, before and after. */
+static unsigned short append_signature(unsigned int *tx,
+                                       unsigned char key_ix,
+                                       const unsigned char *der_sig,
+                                       unsigned int der_sig_len) {
+    if ((sign_format & (SIGN_FORMAT_RAW | SIGN_FORMAT_WITNESS)) == 0) {
+        CHECK_SW(check_response_space(*tx, der_sig_len));
+        memmove(G_io_apdu_buffer + *tx, der_sig, der_sig_len);
+        *tx += der_sig_len;
+        return SW_OK;
+    }
+
+    unsigned char raw_sig[RAW_SIG_LEN];
+    if (!der_to_raw_sig(der_sig, der_sig_len, raw_sig)) {
+        return 0x6D00;
+    }
+
+    if (sign_format & SIGN_FORMAT_RAW) {
+        CHECK_SW(check_response_space(*tx, sizeof(raw_sig)));
+        memmove(G_io_apdu_buffer + *tx, raw_sig, sizeof(raw_sig));
+        *tx += sizeof(raw_sig);
+    } else {
+        CHECK_SW(check_response_space(*tx, der_sig_len));
+        memmove(G_io_apdu_buffer + *tx, der_sig, der_sig_len);
+        *tx += der_sig_len;
+    }
+
+    if (sign_format & SIGN_FORMAT_WITNESS) {
+        CHECK_SW(check_response_space(*tx, WITNESS_LEN));
+        cx_ecfp_public_key_t public_key;
+        if (cx_ecfp_generate_pair_no_throw(CX_CURVE_256R1,
+                                           &public_key,
+                                           &signing_ctx.private_keys[key_ix],
+                                           1) != CX_OK) {
+            return 0x6D00;
+        }
+        *tx += write_witness(G_io_apdu_buffer + *tx, raw_sig, public_key.W);
+    }
+    return SW_OK;
+}
+
+/** add what follows the signatures to the response: the transaction id if asked for, or the hash
+ * in the legacy format of single signatures, so we can see where the bug is. tx is the response
+ * length, before and after. */
+static unsigned short append_response_suffix(unsigned int *tx) {
+    if (sign_format & SIGN_FORMAT_TXID) {
+        // the transaction id is the double SHA-256 of the transaction, in serialization order.
+        CHECK_SW(check_response_space(*tx, CX_SHA256_SIZE));
+        cx_hash_sha256(signing_ctx.hash,
+                       sizeof(signing_ctx.hash),
+                       G_io_apdu_buffer + *tx,
+                       CX_SHA256_SIZE);
+        *tx += CX_SHA256_SIZE;
+    } else if ((sign_format == SIGN_FORMAT_LEGACY) && (!signing_ctx.multi_sign)) {
+        CHECK_SW(check_response_space(*tx, 2 + CX_SHA256_SIZE));
+        G_io_apdu_buffer[(*tx)++] = 0xFF;
+        G_io_apdu_buffer[(*tx)++] = 0xFF;
+        for (int ix = 0; ix < 32; ix++) {
+            G_io_apdu_buffer[(*tx)++] = signing_ctx.hash[ix];
+        }
+    }
+    return SW_OK;
+}
+
+/** sign the hash in the signing context with each of its keys, and write the response without its
+ * status word. tx is the response length, before and after. */
+static unsigned short sign_tx(unsigned int *tx) {
+    if (signing_ctx.key_count == 0) {
+        return 0x6D00;
+    }
+
+    // one signature per key, the DER encoding tells where each signature ends.
+    for (unsigned char key_ix = 0; key_ix < signing_ctx.key_count; key_ix++) {
+        unsigned char der_sig[MAX_DER_SIG_LEN];
+        size_t sig_len = sizeof(der_sig);
+        PROFILE_STAGE(STAGE_SIGN, sizeof(signing_ctx.hash));
+        if (cx_ecdsa_sign_no_throw(&signing_ctx.private_keys[key_ix],
+                                   CX_RND_RFC6979 | CX_LAST,
+                                   CX_SHA256,
+                                   signing_ctx.hash,
+                                   sizeof(signing_ctx.hash),
+                                   der_sig,
+                                   &sig_len,
+                                   NULL) != CX_OK) {
+            return 0x6D00;
+        }
+        // keep the signature, a retry of the same transaction gets it back without a review.
+        if (!signing_ctx.multi_sign) {
+            sig_cache_add(signing_ctx.hash, signing_ctx.bip44_path, der_sig, sig_len);
+        }
+        CHECK_SW(append_signature(tx, key_ix, der_sig, sig_len));
+    }
+    return append_response_suffix(tx);
+}
+
+/** signs the transaction if this is its last part and sends the response, returns its status
+ * word. */
+unsigned short sign_tx_and_send(void) {
+    unsigned int tx = 0;
+    unsigned short sw = SW_OK;
+
+    if (G_io_apdu_buffer[2] == P1_LAST) {
+        session.state = SESSION_SIGNING;
+        sw = sign_tx(&tx);
+        clear_signing_context();
+        if (sw != SW_OK) {
+            tx = 0;
+        }
+
+        // G_io_apdu_buffer[0] &= 0xF0; // discard the parity information
+        session_end();
+        clear_tx_desc();
+        raw_tx_ix = 0;
+        raw_tx_len = 0;
+    }
+    tx = append_status_word(tx, sw);
+    // Send back the response, do not restart the event loop
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, tx);
+    return sw;
+}
+
 /** processes the transaction approval. the UI is only displayed when all of the TX has been sent
  * over for signing. */
 const void *sign_tx_and_send_response(void) {
+    sign_tx_and_send();
+    // Display back the original UX. the progress of the upload stays until the last part ends the
+    // session.
+#ifdef HAVE_BAGL
+    if (uiState != UI_PROGRESS) {
+        ui_idle();
+    }
+#endif
+    return 0;  // do not redraw the widget
+}
+
+/** answer a retry of a transaction that was already signed with its cached signature, without a
+ * review. returns false, and sends nothing, if the signature is not cached. */
+bool sign_tx_from_cache(void) {
+    if ((signing_ctx.key_count != 1) || signing_ctx.multi_sign) {
+        return false;
+    }
+
+    unsigned char der_sig[MAX_DER_SIG_LEN];
+    unsigned int sig_len = sig_cache_get(signing_ctx.hash, signing_ctx.bip44_path, der_sig);
+    if (sig_len == 0) {
+        return false;
+    }
     unsigned int tx = 0;
+    unsigned short sw = append_signature(&tx, 0, der_sig, sig_len);
+    if (sw == SW_OK) {
+        sw = append_response_suffix(&tx);
+    }
+    clear_signing_context();
+    if (sw != SW_OK) {
+        tx = 0;
+    }
 
-    if (G_io_apdu_buffer[2] == P1_LAST) {
-        unsigned int raw_tx_len_except_bip44 = raw_tx_len - BIP44_BYTE_LENGTH;
-        // Update and sign the hash
-        CX_ASSERT(cx_hash_no_throw(&tx_hash.header, 0, raw_tx, raw_tx_len_except_bip44, NULL, 0));
+    session_end();
+    clear_tx_desc();
+    raw_tx_ix = 0;
+    raw_tx_len = 0;
+
+    tx = append_status_word(tx, sw);
+    // Send back the response, do not restart the event loop
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, tx);
+    return true;
+}
 
-        unsigned char *bip44_in = raw_tx + raw_tx_len_except_bip44;
+/** validate the path_count BIP44 paths at the end of raw_tx, derive their private keys and hash the
+ * transaction. this runs once after the last part of the transaction arrives, before the review is
+ * shown, so the slow key derivation is not between the user's approval and the signature. */
+unsigned short prepare_signing_context(unsigned char path_count, bool multi_sign) {
+    clear_signing_context();
 
+    if ((path_count == 0) || (path_count > MAX_SIGN_PATHS)) {
+        session_end();
+        return 0x6A86;
+    }
+    if (raw_tx_len < path_count * BIP44_BYTE_LENGTH) {
+        session_end();
+        return 0x6D08;
+    }
+    unsigned int raw_tx_len_except_bip44 = raw_tx_len - (path_count * BIP44_BYTE_LENGTH);
+
+    unsigned char *bip44_in = raw_tx + raw_tx_len_except_bip44;
+
+    for (unsigned char key_ix = 0; key_ix < path_count; key_ix++) {
         /** BIP44 path, used to derive the private key from the mnemonic by calling
          * os_perso_derive_node_bip32. */
         unsigned int bip44_path[BIP44_PATH_LEN];
@@ -776,50 +1285,75 @@ const void *sign_tx_and_send_response(void) {
             bip44_in += 4;
         }
 
-        cx_ecfp_private_key_t privateKey;
+        PROFILE_STAGE(STAGE_DERIVE, 0);
         if (bip32_derive_init_privkey_256(CX_CURVE_256R1,
                                           bip44_path,
                                           BIP44_PATH_LEN,
-                                          &privateKey,
+                                          &signing_ctx.private_keys[key_ix],
                                           NULL) != CX_OK) {
-            THROW(0x6D00);
+            clear_signing_context();
+            session_end();
+            return 0x6D00;
         }
+    }
 
-        // Hash is finalized, send back the signature
-        unsigned char result[32];
+    // Finish the hash once for all keys, only the signatures are left for the approval.
+    if (cx_hash_no_throw(&session.tx_hash.header,
+                         CX_LAST,
+                         raw_tx,
+                         raw_tx_len_except_bip44,
+                         signing_ctx.hash,
+                         sizeof(signing_ctx.hash)) != CX_OK) {
+        clear_signing_context();
+        session_end();
+        return 0x6D00;
+    }
+    memmove(signing_ctx.bip44_path, raw_tx + raw_tx_len_except_bip44, BIP44_BYTE_LENGTH);
 
-        CX_ASSERT(cx_hash_no_throw(&tx_hash.header, CX_LAST, G_io_apdu_buffer, 0, result, 32));
+    signing_ctx.multi_sign = multi_sign;
+    signing_ctx.key_count = path_count;
+    return SW_OK;
+}
 
-        size_t sig_len = sizeof(G_io_apdu_buffer);
-        if (cx_ecdsa_sign_no_throw((void *) &privateKey,
-                                   CX_RND_RFC6979 | CX_LAST,
-                                   CX_SHA256,
-                                   result,
-                                   sizeof(result),
-                                   G_io_apdu_buffer,
-                                   &sig_len,
-                                   NULL) != CX_OK) {
-            THROW(0x6D00);
-        }
-        tx = sig_len;
+/** wipe the signing context, including the derived private key. */
+void clear_signing_context(void) {
+    explicit_bzero(&signing_ctx, sizeof(signing_ctx));
+}
 
-        // G_io_apdu_buffer[0] &= 0xF0; // discard the parity information
-        hashTainted = 1;
-        clear_tx_desc();
-        raw_tx_ix = 0;
-        raw_tx_len = 0;
+/** start a new signing session: reset the hash and all the other temporary variables of the
+ * transaction. */
+void session_begin(void) {
+    clear_signing_context();
+    cx_sha256_init(&session.tx_hash);
+    raw_tx_ix = 0;
+    raw_tx_len = 0;
+    session.seq = 0;
+    session.crc = RAW_TX_CRC_INIT;
+    session.total_len = 0;
+    session.parts = 0;
+    session.state = SESSION_RECEIVING;
+}
 
-        // add hash to the response, so we can see where the bug is.
-        G_io_apdu_buffer[tx++] = 0xFF;
-        G_io_apdu_buffer[tx++] = 0xFF;
-        for (int ix = 0; ix < 32; ix++) {
-            G_io_apdu_buffer[tx++] = result[ix];
-        }
+/** end the signing session. what it received is reset when the next one begins. the progress of
+ * the upload is not shown any more. */
+void session_end(void) {
+    session.state = SESSION_IDLE;
+    if (uiState == UI_PROGRESS) {
+        ui_idle();
     }
-    G_io_apdu_buffer[tx++] = 0x90;
-    G_io_apdu_buffer[tx++] = 0x00;
+}
+
+/** deny signing. */
+static const void *reject_tx_and_send_response(void) {
+    session_end();
+    clear_signing_context();
+    clear_tx_desc();
+    raw_tx_ix = 0;
+    raw_tx_len = 0;
+    G_io_apdu_buffer[0] = 0x69;
+    G_io_apdu_buffer[1] = 0x85;
     // Send back the response, do not restart the event loop
-    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, tx);
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
     // Display back the original UX
 #ifdef HAVE_BAGL
     ui_idle();
@@ -827,12 +1361,32 @@ const void *sign_tx_and_send_response(void) {
     return 0;  // do not redraw the widget
 }
 
-/** deny signing. */
-static const void *reject_tx_and_send_response(void) {
-    hashTainted = 1;
+/** approve the batch, its signatures can then be requested one by one. */
+static const void *approve_batch_and_send_response(void) {
+    batch.approved = true;
     clear_tx_desc();
-    raw_tx_ix = 0;
-    raw_tx_len = 0;
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_TX;
+#endif
+    G_io_apdu_buffer[0] = batch.count;
+    G_io_apdu_buffer[1] = 0x90;
+    G_io_apdu_buffer[2] = 0x00;
+    // Send back the response, do not restart the event loop
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 3);
+    // Display back the original UX
+#ifdef HAVE_BAGL
+    ui_idle();
+#endif
+    return 0;  // do not redraw the widget
+}
+
+/** deny the batch, all of its transactions are dropped. */
+static const void *reject_batch_and_send_response(void) {
+    batch_clear();
+    clear_tx_desc();
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_TX;
+#endif
     G_io_apdu_buffer[0] = 0x69;
     G_io_apdu_buffer[1] = 0x85;
     // Send back the response, do not restart the event loop
@@ -844,6 +1398,110 @@ static const void *reject_tx_and_send_response(void) {
     return 0;  // do not redraw the widget
 }
 
+/** approve the policy, the transactions within it are then signed without review. */
+static const void *approve_policy_and_send_response(void) {
+    policy_approve();
+    clear_tx_desc();
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_TX;
+#endif
+    G_io_apdu_buffer[0] = 0x90;
+    G_io_apdu_buffer[1] = 0x00;
+    // Send back the response, do not restart the event loop
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
+    // Display back the original UX
+#ifdef HAVE_BAGL
+    ui_idle();
+#endif
+    return 0;  // do not redraw the widget
+}
+
+/** deny the policy, every transaction is reviewed as before. */
+static const void *reject_policy_and_send_response(void) {
+    policy_clear();
+    clear_tx_desc();
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_TX;
+#endif
+    G_io_apdu_buffer[0] = 0x69;
+    G_io_apdu_buffer[1] = 0x85;
+    // Send back the response, do not restart the event loop
+    io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, 2);
+    // Display back the original UX
+#ifdef HAVE_BAGL
+    ui_idle();
+#endif
+    return 0;  // do not redraw the widget
+}
+
+/** show the review of the pending spending policy. */
+unsigned short ui_policy_review(void) {
+    CHECK_SW(policy_display_desc());
+    PROFILE_STAGE(STAGE_REVIEW, max_scr_ix);
+
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_POLICY;
+    ui_top_sign();
+#elif defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    unsigned int step_ix = 0;
+    ux_policy_flow[step_ix++] = &ux_policy_flow_intro_step;
+    for (unsigned int scr_ix = 0; scr_ix < max_scr_ix; scr_ix++) {
+        ux_policy_flow[step_ix++] = ux_policy_steps[scr_ix];
+    }
+    ux_policy_flow[step_ix++] = &ux_policy_flow_accept_step;
+    ux_policy_flow[step_ix++] = &ux_policy_flow_reject_step;
+    ux_policy_flow[step_ix++] = FLOW_END_STEP;
+
+    uiState = UI_TOP_SIGN;
+    // reserve a display stack slot if none yet
+    if (G_ux.stack_count == 0) {
+        ux_stack_push();
+    }
+    ux_flow_init(0, ux_policy_flow, NULL);
+#elif defined(TARGET_STAX) || defined(TARGET_FLEX)
+    uiState = UI_TOP_SIGN;
+    policyReviewStart();
+#endif  // #if TARGET_ID
+    return SW_OK;
+}
+
+/** show the review of all the transactions of the batch. */
+unsigned short ui_batch_review(void) {
+    CHECK_SW(batch_display_desc());
+    PROFILE_STAGE(STAGE_REVIEW, max_scr_ix);
+#ifdef HAVE_BAGL
+    snprintf(batch_title, sizeof(batch_title), "%d Transactions", batch.count);
+#else
+    snprintf(batch_title, sizeof(batch_title), "Review %d transactions", batch.count);
+#endif
+
+#if defined(TARGET_NANOS)
+    reviewKind = REVIEW_BATCH;
+    ui_top_sign();
+#elif defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    unsigned int step_ix = 0;
+    ux_batch_flow[step_ix++] = &ux_batch_flow_intro_step;
+    for (unsigned char batch_ix = 0; batch_ix < batch.count; batch_ix++) {
+        ux_batch_flow[step_ix++] = ux_batch_tx_steps[batch_ix][0];
+        ux_batch_flow[step_ix++] = ux_batch_tx_steps[batch_ix][1];
+    }
+    ux_batch_flow[step_ix++] = &ux_batch_flow_accept_step;
+    ux_batch_flow[step_ix++] = &ux_batch_flow_reject_step;
+    ux_batch_flow[step_ix++] = FLOW_END_STEP;
+
+    uiState = UI_TOP_SIGN;
+    // reserve a display stack slot if none yet
+    if (G_ux.stack_count == 0) {
+        ux_stack_push();
+    }
+    ux_flow_init(0, ux_batch_flow, NULL);
+#elif defined(TARGET_STAX) || defined(TARGET_FLEX)
+    uiState = UI_TOP_SIGN;
+    batchReviewStart();
+#endif  // #if TARGET_ID
+    return SW_OK;
+}
+
 /** show the idle screen. */
 void ui_idle(void) {
     uiState = UI_IDLE;
@@ -876,6 +1534,33 @@ void ui_idle(void) {
 #endif  // #if TARGET_ID
 }
 
+/** show how much of the transaction arrived. the first part gave the total length. */
+void ui_upload_progress(void) {
+    if (session.total_len == 0) {
+        return;
+    }
+    unsigned int percent = (raw_tx_ix * 100) / session.total_len;
+    if (percent > 99) {
+        percent = 99;
+    }
+    uiState = UI_PROGRESS;
+
+#if defined(TARGET_NANOS)
+    snprintf(progress_text, sizeof(progress_text), "%u%%", percent);
+    UX_DISPLAY(bagl_ui_progress_nanos, NULL);
+#elif defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    snprintf(progress_text, sizeof(progress_text), "%u%%", percent);
+    // reserve a display stack slot if none yet
+    if (G_ux.stack_count == 0) {
+        ux_stack_push();
+    }
+    ux_flow_init(0, ux_progress_flow, NULL);
+#elif defined(TARGET_STAX) || defined(TARGET_FLEX)
+    snprintf(progress_text, sizeof(progress_text), "Receiving transaction %u%%", percent);
+    nbgl_useCaseSpinner(progress_text);
+#endif  // #if TARGET_ID
+}
+
 /** show the top "Sign Transaction" screen. */
 void ui_top_sign(void) {
     uiState = UI_TOP_SIGN;
@@ -887,7 +1572,11 @@ void ui_top_sign(void) {
     if (G_ux.stack_count == 0) {
         ux_stack_push();
     }
-    ux_flow_init(0, ux_confirm_single_flow, NULL);
+    if (tx_summary.inputs_scr_ix != 0) {
+        ux_flow_init(0, ux_confirm_fee_flow, NULL);
+    } else {
+        ux_flow_init(0, ux_confirm_single_flow, NULL);
+    }
 #elif defined(TARGET_STAX) || defined(TARGET_FLEX)
     reviewStart();
 #endif  // #if TARGET_ID
@@ -899,6 +1588,44 @@ unsigned int get_apdu_buffer_length() {
     return len0;
 }
 
+/** return the CRC-16/CCITT of len bytes at buf, continued from crc. bitwise, as the parts are
+ * small. */
+unsigned short crc16_update(unsigned short crc, const unsigned char *buf, unsigned int len) {
+    for (unsigned int ix = 0; ix < len; ix++) {
+        crc ^= buf[ix] << 8;
+        for (unsigned char bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/** write the offset of the body of the rx bytes APDU in the communication buffer to offset, and its
+ * length to len. a short APDU with a body never has a zero length byte, so a zero length byte
+ * followed by more bytes starts an extended length. the body must end before the end of the
+ * buffer, which the caller terminates with a zero. */
+unsigned short get_apdu_body(unsigned int rx, unsigned int *offset, unsigned int *len) {
+    if ((G_io_apdu_buffer[APDU_BODY_LENGTH_OFFSET] != 0) || (rx <= APDU_HEADER_LENGTH)) {
+        *offset = APDU_HEADER_LENGTH;
+        *len = get_apdu_buffer_length();
+        return SW_OK;
+    }
+
+    if (rx < EXTENDED_APDU_HEADER_LENGTH) {
+        session_end();
+        return 0x6D1E;
+    }
+    *len = (G_io_apdu_buffer[APDU_BODY_LENGTH_OFFSET + 1] << 8) |
+           G_io_apdu_buffer[APDU_BODY_LENGTH_OFFSET + 2];
+    if ((EXTENDED_APDU_HEADER_LENGTH + *len != rx) ||
+        (EXTENDED_APDU_HEADER_LENGTH + *len >= sizeof(G_io_apdu_buffer))) {
+        session_end();
+        return 0x6D1E;
+    }
+    *offset = EXTENDED_APDU_HEADER_LENGTH;
+    return SW_OK;
+}
+
 /** sets the tx_desc variables to no information */
 static void clear_tx_desc(void) {
     for (uint8_t i = 0; i < MAX_TX_TEXT_SCREENS; i++) {
@@ -911,3 +1638,12 @@ static void clear_tx_desc(void) {
     strncpy(tx_desc[1][0], NO_INFO, sizeof(NO_INFO));
     strncpy(tx_desc[2][0], NO_INFO, sizeof(NO_INFO));
 }
+
+/** the tx_desc screens are filled, the review shows scr_count of them from the first. */
+void start_tx_desc(unsigned int scr_count) {
+    curr_scr_ix = 0;
+    max_scr_ix = scr_count;
+#ifdef HAVE_BAGL
+    memmove(curr_tx_desc, tx_desc[curr_scr_ix], CURR_TX_DESC_LEN);
+#endif
+}
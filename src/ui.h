@@ -21,12 +21,28 @@ extern int exit_timer;
 /** display for the timer */
 extern char timer_desc[MAX_TIMER_TEXT_WIDTH];
 
+/** status word of a successful operation, the functions that can fail return a status word. */
+#define SW_OK 0x9000
+
+/** return the status word of call from the calling function, unless it is SW_OK. */
+#define CHECK_SW(call)                     \
+    do {                                   \
+        unsigned short check_sw_ = (call); \
+        if (check_sw_ != SW_OK) {          \
+            return check_sw_;              \
+        }                                  \
+    } while (0)
+
 /** length of the APDU (application protocol data unit) header. */
 #define APDU_HEADER_LENGTH 5
 
 /** offset in the APDU header which says the length of the body. */
 #define APDU_BODY_LENGTH_OFFSET 4
 
+/** length of the header of an extended length APDU, where the body length is a zero byte followed
+ * by two bytes big endian. */
+#define EXTENDED_APDU_HEADER_LENGTH 7
+
 /** for signing, indicates this is the last part of the transaction. */
 #define P1_LAST 0x80
 
@@ -34,12 +50,39 @@ extern char timer_desc[MAX_TIMER_TEXT_WIDTH];
  * coming. */
 #define P1_MORE 0x00
 
+/** for signing, flag added to P1_MORE or P1_LAST when the part starts with its sequence number and
+ * the checksum of the transaction so far, so a lost part is detected and the upload resumes. */
+#define P1_SEQUENCED 0x40
+
+/** length of the header of a sequenced part: <sequence number, 2 bytes> <crc16 of the transaction
+ * up to the end of the part, 2 bytes>, both big endian. */
+#define SEQUENCED_PART_HEADER_LENGTH 4
+
+/** for signing, flag added to the first part when it gives the length of the whole transaction, so
+ * the progress of the upload can be shown. the part starts with the length, 2 bytes big endian,
+ * after the sequenced part header if any. */
+#define P1_TOTAL_LENGTH 0x20
+
+/** length of the total length at the start of the first part. */
+#define TOTAL_LENGTH_HEADER_LENGTH 2
+
+/** the progress of an upload is shown on the first part, then every few parts, so showing it does
+ * not slow down fast uploads. */
+#define PROGRESS_UPDATE_PARTS 4
+
+/** initial value of the transaction checksum. */
+#define RAW_TX_CRC_INIT 0xFFFF
+
 /** length of BIP44 path */
 #define BIP44_PATH_LEN 5
 
 /** length of BIP44 path, in bytes */
 #define BIP44_BYTE_LENGTH (BIP44_PATH_LEN * sizeof(unsigned int))
 
+/** max number of BIP44 paths signing a single transaction, bound by the number of DER signatures
+ * that fit in one response. */
+#define MAX_SIGN_PATHS 3
+
 /**
  * Nano S has 320 KB flash, 10 KB RAM, uses a ST31H320 chip.
  * This effectively limits the max size
@@ -82,7 +125,8 @@ enum UI_STATE {
     UI_SIGN,
     UI_DENY,
     UI_PUBLIC_KEY_1,
-    UI_PUBLIC_KEY_2
+    UI_PUBLIC_KEY_2,
+    UI_PROGRESS
 };
 
 /** UI state enum */
@@ -91,15 +135,9 @@ extern enum UI_STATE uiState;
 /** UI state flag */
 extern ux_state_t ux;
 
-/** notification to restart the hash */
-extern unsigned char hashTainted;
-
 /** notification to refresh the view, if we are displaying the public key */
 extern unsigned char publicKeyNeedsRefresh;
 
-/** the hash. */
-extern cx_sha256_t tx_hash;
-
 /** index of the current screen. */
 extern unsigned int curr_scr_ix;
 
@@ -115,25 +153,162 @@ extern unsigned int raw_tx_ix;
 /** current length of raw transaction. */
 extern unsigned int raw_tx_len;
 
-/** all text descriptions. */
+/** the states of the signing session. */
+enum SESSION_STATE {
+    /** no transaction, the next part starts a new one. */
+    SESSION_IDLE,
+    /** the parts of the transaction are being received into raw_tx. */
+    SESSION_RECEIVING,
+    /** the transaction is parsed, its keys are derived and the user reviews it. */
+    SESSION_REVIEWING,
+    /** the transaction is approved and being signed. */
+    SESSION_SIGNING
+};
+
+/** the signing session, from the first part of a transaction to its signature. an error in one of
+ * the instructions that drive it ends it, the other instructions leave it as it is. */
+typedef struct {
+    /** the state of the session, see SESSION_STATE. */
+    unsigned char state;
+
+    /** the hash of the transaction. */
+    cx_sha256_t tx_hash;
+
+    /** sequence number of the next sequenced part of the transaction. */
+    unsigned short seq;
+
+    /** checksum of the sequenced parts of the transaction received so far. */
+    unsigned short crc;
+
+    /** length of the whole transaction, given by its first part, zero if it did not. */
+    unsigned short total_len;
+
+    /** number of parts of the transaction received so far. */
+    unsigned short parts;
+} session_t;
+
+/** the signing session. */
+extern session_t session;
+
+/** all text descriptions. on NBGL devices the 9 screens of three 54 byte lines take 1458 bytes,
+ * much of it the unused ends of short lines. they are not packed into a pool of strings: the
+ * parser and the policy and batch reviews write each line in place by screen and line, the NBGL
+ * reviews point into the lines, and the totals of the inputs take up to 52 characters of a line.
+ * Stax and Flex have the RAM for it, the bagl devices, the Nano S short of RAM among them, use 18
+ * byte lines. */
 extern char tx_desc[MAX_TX_TEXT_SCREENS][MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
 
-/** currently displayed text description. */
+#ifdef HAVE_BAGL
+/** currently displayed text description. the NBGL reviews point into tx_desc instead. */
 extern char curr_tx_desc[MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
 
+/** lines of the displayed address, which takes three short ones. */
+#define ADDRESS58_LINES MAX_TX_TEXT_LINES
+#else
+/** lines of the displayed address, which takes one long one. */
+#define ADDRESS58_LINES 1
+#endif
+
 /** currently displayed address */
-extern char address58[MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
+extern char address58[ADDRESS58_LINES][MAX_TX_TEXT_WIDTH];
+
+/** the tx_desc screens are filled, the review shows scr_count of them from the first. */
+void start_tx_desc(unsigned int scr_count);
+
+/** max length of a DER encoded secp256r1 signature. */
+#define MAX_DER_SIG_LEN 72
+
+/** length of a signature as the 32 byte r followed by the 32 byte s. */
+#define RAW_SIG_LEN 64
+
+/** signature response in the legacy format: DER signature, then 0xFF 0xFF and the hash. */
+#define SIGN_FORMAT_LEGACY 0x00
+
+/** signature response flag: 64 byte r||s signatures instead of DER. */
+#define SIGN_FORMAT_RAW 0x01
+
+/** signature response flag: the transaction id after the signatures. */
+#define SIGN_FORMAT_TXID 0x02
+
+/** signature response flag: the serialized witness of each key after its signature. */
+#define SIGN_FORMAT_WITNESS 0x04
+
+/** all the signature response flags. */
+#define SIGN_FORMAT_ALL (SIGN_FORMAT_RAW | SIGN_FORMAT_TXID | SIGN_FORMAT_WITNESS)
+
+/** the format of the signature responses, SIGN_FORMAT_* flags. */
+extern unsigned char sign_format;
+
+/** signing state prepared while the transaction is under review, so approval only has to sign. */
+typedef struct {
+    /** private keys derived from the BIP44 paths at the end of raw_tx, in the order of the paths. */
+    cx_ecfp_private_key_t private_keys[MAX_SIGN_PATHS];
+
+    /** the final hash of the transaction, which is what gets signed. */
+    unsigned char hash[CX_SHA256_SIZE];
+
+    /** the BIP44 path of the first key, as received. */
+    unsigned char bip44_path[BIP44_BYTE_LENGTH];
+
+    /** number of derived keys, zero until the keys are ready. */
+    unsigned char key_count;
+
+    /** true if the response is the list of signatures only, without the legacy hash suffix. */
+    bool multi_sign;
+} signing_context_t;
+
+/** the signing context for the transaction under review. */
+extern signing_context_t signing_ctx;
+
+/** validate the path_count BIP44 paths at the end of raw_tx, derive their private keys and hash the
+ * transaction, called once the last part of the transaction has been received. */
+unsigned short prepare_signing_context(unsigned char path_count, bool multi_sign);
+
+/** wipe the signing context, including the derived private key. */
+void clear_signing_context(void);
+
+/** start a new signing session, for the first part of a transaction. */
+void session_begin(void);
+
+/** end the signing session, the next part of a transaction starts a new one. */
+void session_end(void);
+
+/** sign the transaction if this is its last part and send the response, returns its status word.
+ */
+unsigned short sign_tx_and_send(void);
 
 /** process a partial transaction */
 const void *sign_tx_and_send_response(void);
 
+/** answer a retry of an already signed transaction from the signature cache, false on a miss */
+bool sign_tx_from_cache(void);
+
 /** show the idle UI */
 void ui_idle(void);
 
 /** show the "Sign TX" ui, starting at the top of the Tx display */
 void ui_top_sign(void);
 
+/** show how much of the transaction arrived, out of the total length its first part gave */
+void ui_upload_progress(void);
+
+/** show the review of all the transactions of the batch, returns the status word */
+unsigned short ui_batch_review(void);
+
+/** show the review of the pending spending policy, returns the status word */
+unsigned short ui_policy_review(void);
+
 /** return the length of the communication buffer */
 unsigned int get_apdu_buffer_length();
 
+/** return the CRC-16/CCITT of len bytes at buf, continued from crc. */
+unsigned short crc16_update(unsigned short crc, const unsigned char *buf, unsigned int len);
+
+/** write the offset of the body of the rx bytes APDU in the communication buffer to offset, and its
+ * length to len. both short and extended length APDUs are accepted. */
+unsigned short get_apdu_body(unsigned int rx, unsigned int *offset, unsigned int *len);
+
+/** write the status word sw after the tx bytes of the response, returns the response length */
+unsigned int append_status_word(unsigned int tx, unsigned short sw);
+
 #endif  // UI_H
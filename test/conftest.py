@@ -14,3 +14,11 @@ configuration.OPTIONAL.CUSTOM_SEED = MNEMONIC
 
 # Pull all features from the base ragger conftest using the overridden configuration
 pytest_plugins = ("ragger.conftest.base_conftest", )
+
+
+def pytest_addoption(parser):
+    parser.addoption("--latency-json",
+                     action="store",
+                     default=None,
+                     help="run test_latency_benchmark.py and write its "
+                     "results to this JSON file")
@@ -0,0 +1,48 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, INS_GET_APP_CONFIGURATION, INS_GET_PUBLIC_KEY,
+                   INS_SET_POLICY, P1_POLICY_SET, serialize)
+
+INS_UNKNOWN = 0x7E
+
+
+def exchange_status(backend, apdu):
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange_raw(apdu)
+    return e.value.status
+
+
+def test_apdu_body_shorter_than_length(backend):
+    apdu = serialize(CLA, INS_SET_POLICY, P1_POLICY_SET, 0x00, bytes(16))
+    # the length byte says one more byte than was sent
+    apdu = apdu[:4] + bytes([16 + 1]) + apdu[5:]
+    assert exchange_status(backend, apdu) == 0x6D21
+
+    # the error is a status word, the app keeps answering
+    assert len(backend.exchange(CLA, INS_GET_APP_CONFIGURATION).data) == 11
+
+
+def test_apdu_bip44_path_too_short(backend):
+    apdu = serialize(CLA, INS_GET_PUBLIC_KEY, 0x00, 0x00, bytes(12))
+    assert exchange_status(backend, apdu) == 0x6D09
+
+
+def test_apdu_unknown_instruction(backend):
+    assert exchange_status(backend, serialize(CLA, INS_UNKNOWN)) == 0x6D00
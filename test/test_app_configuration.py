@@ -0,0 +1,47 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import re
+from pathlib import Path
+from utils import CLA, INS_GET_APP_CONFIGURATION, MAX_EXTENDED_APDU_SIZE
+
+CAPABILITY_EXTENDED_APDU = 0x0001
+MAX_TX_RAW_LENGTH = 1024
+MAKEFILE = Path(__file__).parent.parent.resolve() / "Makefile"
+
+
+def get_app_version():
+    makefile = MAKEFILE.read_text()
+    return tuple(
+        int(re.search(rf"^APPVERSION_{part}\s*=\s*(\d+)", makefile,
+                      re.MULTILINE).group(1)) for part in "MNP")
+
+
+def test_app_configuration(backend):
+    response = backend.exchange(CLA, INS_GET_APP_CONFIGURATION).data
+    assert len(response) == 11
+    assert tuple(response[0:3]) == get_app_version()
+
+    capabilities = int.from_bytes(response[3:5], "big")
+    max_part_len = int.from_bytes(response[5:7], "big")
+    assert int.from_bytes(response[7:9], "big") == MAX_TX_RAW_LENGTH
+    assert response[9] >= 1
+    assert response[10] >= 1
+
+    # a host can send transactions in extended parts
+    assert capabilities & CAPABILITY_EXTENDED_APDU
+    assert max_part_len >= MAX_EXTENDED_APDU_SIZE
@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import struct
+from hashlib import sha256
+from utils import (CLA, DEFAULT_PATH, INS_ATTEST_INPUT, MAX_APDU_SIZE,
+                   P1_ATTEST_LOAD, P1_LAST, P1_MORE, P2_ATTEST_FIRST,
+                   SIGDER_LEN_OFFSET, check_tx_nist256, get_packed_path,
+                   get_public_key, sign_tx)
+from test_GAS_NEO import rawText_00
+
+GAS_ASSET_ID = bytes.fromhex(
+    "e72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60")
+DESTINATION = bytes.fromhex("13354f4f5d3f989a221c794271e0bb2471c2735e")
+ATTESTATION_LEN = 106
+
+
+def attest(backend, prev_tx, index):
+    data = struct.pack("<H", index) + prev_tx
+    offset = 0
+    while offset != len(data):
+        chunk = data[offset:offset + MAX_APDU_SIZE]
+        p2 = P2_ATTEST_FIRST if offset == 0 else 0x00
+        offset += len(chunk)
+        p1 = P1_LAST if offset == len(data) else P1_MORE
+        response = backend.exchange(CLA, INS_ATTEST_INPUT, p1, p2, chunk)
+    return response.data
+
+
+def test_attest_input(backend, firmware, navigator):
+    txid = sha256(sha256(rawText_00).digest()).digest()
+
+    # the two GAS outputs of rawText_00, 0.001 and 0.0008189 GAS
+    attestations = [attest(backend, rawText_00, ix) for ix in range(2)]
+    for ix, attestation in enumerate(attestations):
+        assert len(attestation) == ATTESTATION_LEN
+        assert attestation[:34] == txid + struct.pack("<H", ix)
+        backend.exchange(CLA, INS_ATTEST_INPUT, P1_ATTEST_LOAD, 0x00,
+                         attestation)
+
+    # spend both, 0.0015 GAS out, leaving a fee of 0.0003189 GAS
+    tx = bytes([0x80, 0x00, 0x00, 0x02]) + txid + struct.pack(
+        "<H", 0) + txid + struct.pack("<H", 1) + bytes(
+            [0x01]) + GAS_ASSET_ID + struct.pack("<Q", 150000) + DESTINATION
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    sigDer = sign_tx(backend, firmware, navigator, tx + get_packed_path(),
+                     None, True)
+    sigLen = sigDer.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(tx, sigDer.data[:sigLen + 2], publicKey)
@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, INS_DRY_RUN, P1_DRY_RUN_OUTPUTS, get_packed_path,
+                   sign_tx)
+from test_GAS_NEO import rawText_01, textToSign_01
+
+TAG_ERROR = 0x01
+TAG_TYPE = 0x02
+TAG_OUTPUT_COUNT = 0x03
+TAG_OUTPUT = 0x05
+ASSET_LABEL_NEO = 1
+TX_CONTRACT = 0x80
+
+
+def parse_tlvs(data):
+    tlvs = []
+    offset = 0
+    while offset < len(data):
+        tag, length = data[offset], data[offset + 1]
+        tlvs.append((tag, bytes(data[offset + 2:offset + 2 + length])))
+        offset += 2 + length
+    assert offset == len(data)
+    return tlvs
+
+
+def test_dry_run(backend, firmware, navigator):
+    # no review: the response comes back without navigation
+    response = sign_tx(backend,
+                       firmware,
+                       navigator,
+                       textToSign_01,
+                       None,
+                       False,
+                       ins=INS_DRY_RUN).data
+
+    tlvs = parse_tlvs(response)
+    assert tlvs[0] == (TAG_TYPE, bytes([TX_CONTRACT]))
+    assert tlvs[1] == (TAG_OUTPUT_COUNT, bytes([1]))
+
+    tag, output = tlvs[-1]
+    assert tag == TAG_OUTPUT
+    assert output[0] == 0
+    assert output[1] == ASSET_LABEL_NEO
+    amount_len = output[2]
+    assert output[3:3 + amount_len] == b"1.00000000"
+    assert output[3 + amount_len:] == b"AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT"
+
+    # the outputs of the parsed transaction can be asked for again
+    outputs = backend.exchange(CLA, INS_DRY_RUN, P1_DRY_RUN_OUTPUTS, 0).data
+    assert parse_tlvs(outputs) == [(TAG_OUTPUT, output)]
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_DRY_RUN, P1_DRY_RUN_OUTPUTS, 1)
+    assert e.value.status == 0x6D20
+
+
+def test_dry_run_parse_error(backend, firmware, navigator):
+    # cut in the middle of the output
+    truncated = rawText_01[:45] + get_packed_path()
+    response = sign_tx(backend,
+                       firmware,
+                       navigator,
+                       truncated,
+                       None,
+                       False,
+                       ins=INS_DRY_RUN).data
+
+    tag, error = parse_tlvs(response)[0]
+    assert tag == TAG_ERROR
+    assert int.from_bytes(error[0:2], "big") == 0x6D05
+    assert int.from_bytes(error[2:4], "big") == len(truncated)
@@ -0,0 +1,156 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+"""Latency benchmark of the app on Speculos, skipped unless pytest is given
+--latency-json with the file to write the results to. Run it on every device
+with --device all.
+
+For each device, it measures the GET_PUBLIC_KEY round trip, then for each
+transaction of BENCHMARK_CASES: the round trip of each INS_SIGN part before the
+last, the time from sending the last part to the first review screen, and the
+time from the approval to the signature.
+"""
+import json
+import statistics
+import time
+from pathlib import Path
+import pytest
+from ragger.navigator import NavInsID
+from utils import (CLA, DEFAULT_PATH, INS_SIGN, MAX_APDU_SIZE, P1_LAST,
+                   P1_MORE, PATH_LEN, SIGDER_LEN_OFFSET, check_tx_nist256,
+                   get_packed_path, get_public_key)
+from tx_generator import TX_CLAIM, TX_INVOCATION, build_tx
+
+GET_PUBLIC_KEY_ROUNDS: int = 20
+
+# name, then the build_tx arguments: each series scales one of them
+BENCHMARK_CASES = [
+    ("outputs_1", dict(outputs=1)),
+    ("outputs_2", dict(outputs=2)),
+    ("outputs_4", dict(outputs=4)),
+    ("outputs_8", dict(outputs=8)),
+    ("outputs_12", dict(outputs=12)),
+    ("attributes_4", dict(attributes=4)),
+    ("attributes_16", dict(attributes=16)),
+    ("attributes_32", dict(attributes=32)),
+    ("inputs_8", dict(inputs=8)),
+    ("inputs_16", dict(inputs=16)),
+    ("claims_1", dict(tx_type=TX_CLAIM, inputs=0, claims=1)),
+    ("claims_8", dict(tx_type=TX_CLAIM, inputs=0, claims=8)),
+    ("claims_24", dict(tx_type=TX_CLAIM, inputs=0, claims=24)),
+    ("script_16", dict(tx_type=TX_INVOCATION, script_size=16)),
+    ("script_64", dict(tx_type=TX_INVOCATION, script_size=64)),
+    ("script_252", dict(tx_type=TX_INVOCATION, script_size=252)),
+]
+
+# device, then case, then the results of the case
+results = {}
+
+
+@pytest.fixture(scope="module")
+def latency_json(request):
+    path = request.config.getoption("latency_json")
+    if path is None:
+        pytest.skip("no --latency-json given")
+    yield Path(path)
+    Path(path).write_text(json.dumps({"devices": results}, indent=2) + "\n")
+
+
+def milliseconds(seconds: float) -> float:
+    return round(seconds * 1000, 3)
+
+
+def summary(seconds: list) -> dict:
+    """The count, median, mean and max of durations, in milliseconds."""
+    if len(seconds) == 0:
+        return {"count": 0}
+    return {
+        "count": len(seconds),
+        "median_ms": milliseconds(statistics.median(seconds)),
+        "mean_ms": milliseconds(statistics.mean(seconds)),
+        "max_ms": milliseconds(max(seconds))
+    }
+
+
+def review_instructions(firmware):
+    """How to scroll the review, the text of its approval screen, and how to
+    approve on it, then what is left to go back home once signed."""
+    if firmware.device in ("stax", "flex"):
+        return (NavInsID.SWIPE_CENTER_TO_LEFT, "Hold to",
+                [NavInsID.USE_CASE_REVIEW_CONFIRM], [
+                    NavInsID.USE_CASE_STATUS_DISMISS,
+                    NavInsID.WAIT_FOR_HOME_SCREEN
+                ])
+    return (NavInsID.RIGHT_CLICK, "Accept", [NavInsID.BOTH_CLICK], [])
+
+
+def test_benchmark_get_public_key(backend, firmware, latency_json):
+    durations = []
+    for _ in range(GET_PUBLIC_KEY_ROUNDS):
+        start = time.perf_counter()
+        get_public_key(backend, DEFAULT_PATH)
+        durations.append(time.perf_counter() - start)
+    results.setdefault(firmware.device, {})["get_public_key"] = summary(
+        durations)
+
+
+@pytest.mark.parametrize("name,shape",
+                         BENCHMARK_CASES,
+                         ids=[name for name, _ in BENCHMARK_CASES])
+def test_benchmark_sign(backend, firmware, navigator, latency_json, name,
+                        shape):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    tx = build_tx(**shape) + get_packed_path()
+    parts = [
+        tx[offset:offset + MAX_APDU_SIZE]
+        for offset in range(0, len(tx), MAX_APDU_SIZE)
+    ]
+    scroll, approval_text, approve, dismiss = review_instructions(firmware)
+
+    part_durations = []
+    for part in parts[:-1]:
+        start = time.perf_counter()
+        backend.exchange(CLA, INS_SIGN, P1_MORE, 0x00, part)
+        part_durations.append(time.perf_counter() - start)
+
+    # the screen is polled, the review time is within its polling interval
+    backend.wait_for_home_screen()
+    with backend.exchange_async(CLA, INS_SIGN, P1_LAST, 0x00, parts[-1]):
+        start = time.perf_counter()
+        backend.wait_for_screen_change()
+        review_duration = time.perf_counter() - start
+
+        navigator.navigate_until_text(scroll, [], approval_text)
+        navigator.navigate(approve,
+                           screen_change_before_first_instruction=False,
+                           screen_change_after_last_instruction=False)
+        start = time.perf_counter()
+    response = backend.last_async_response.data
+    sign_duration = time.perf_counter() - start
+    navigator.navigate(dismiss, screen_change_before_first_instruction=False)
+
+    sigLen = response[SIGDER_LEN_OFFSET]
+    check_tx_nist256(tx[:-PATH_LEN], response[:sigLen + 2], publicKey)
+
+    results.setdefault(firmware.device, {})[name] = {
+        "shape": shape,
+        "tx_len": len(tx),
+        "parts": len(parts),
+        "part": summary(part_durations),
+        "last_part_to_review_ms": milliseconds(review_duration),
+        "approval_to_signature_ms": milliseconds(sign_duration)
+    }
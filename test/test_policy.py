@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import struct
+from hashlib import sha256
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_ATTEST_INPUT, INS_SET_POLICY,
+                   P1_ATTEST_LOAD, P1_POLICY_CLEAR, P1_POLICY_SET,
+                   POLICY_ASSET_GAS, POLICY_ASSET_NEO, PATH_LEN,
+                   SIGDER_LEN_OFFSET, check_tx_nist256, get_packed_path,
+                   get_public_key, navigate, sign_tx)
+from test_GAS_NEO import rawText_00, textToSign_00, textToSign_01
+from test_attest_input import GAS_ASSET_ID, attest
+
+# AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT, the destination of the test transactions
+DESTINATION = bytes.fromhex("13354f4f5d3f989a221c794271e0bb2471c2735e")
+
+
+def policy(asset_mask, max_tx_value, max_total_value, max_tx_count,
+           destinations):
+    return struct.pack("<BQQBB", asset_mask, max_tx_value, max_total_value,
+                       max_tx_count, len(destinations)) + b"".join(
+                           destinations) + get_packed_path()
+
+
+def load_attested_inputs(backend):
+    # the two GAS outputs of rawText_00, 0.001 and 0.0008189 GAS
+    for ix in range(2):
+        backend.exchange(CLA, INS_ATTEST_INPUT, P1_ATTEST_LOAD, 0x00,
+                         attest(backend, rawText_00, ix))
+
+
+def spend_attested_inputs(value):
+    # both attested inputs, value GAS to the destination, the rest is the fee
+    txid = sha256(sha256(rawText_00).digest()).digest()
+    return bytes([0x80, 0x00, 0x00, 0x02]) + txid + struct.pack(
+        "<H", 0) + txid + struct.pack("<H", 1) + bytes(
+            [0x01]) + GAS_ASSET_ID + struct.pack("<Q", value) + DESTINATION
+
+
+def test_policy(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+
+    # 0.01 GAS per transaction, 0.02 GAS in total, for at most 2 transactions
+    with backend.exchange_async(
+            CLA, INS_SET_POLICY, P1_POLICY_SET, 0x00,
+            policy(POLICY_ASSET_GAS, 1000000, 2000000, 2, [DESTINATION])):
+        navigate(firmware, navigator)
+
+    # sending GAS to the destination is within the policy, fee included, no
+    # review
+    load_attested_inputs(backend)
+    tx = spend_attested_inputs(150000)
+    sigDer = sign_tx(backend, firmware, navigator, tx + get_packed_path(),
+                     None, False)
+    sigLen = sigDer.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(tx, sigDer.data[:sigLen + 2], publicKey)
+
+    # without attested inputs the fee is not known, it is reviewed as usual
+    sigDer = sign_tx(backend, firmware, navigator, textToSign_00, None, True)
+    sigLen = sigDer.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], sigDer.data[:sigLen + 2],
+                     publicKey)
+
+    # sending NEO is not, it is reviewed as usual
+    sigDer = sign_tx(backend, firmware, navigator, textToSign_01, None, True)
+    sigLen = sigDer.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_01[:-PATH_LEN], sigDer.data[:sigLen + 2],
+                     publicKey)
+
+    backend.exchange(CLA, INS_SET_POLICY, P1_POLICY_CLEAR, 0x00)
+
+
+def test_policy_single_asset(backend, firmware, navigator):
+    # the caps are amounts of one asset, a policy for both NEO and GAS is
+    # refused before any review
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(
+            CLA, INS_SET_POLICY, P1_POLICY_SET, 0x00,
+            policy(POLICY_ASSET_NEO | POLICY_ASSET_GAS, 1000000, 2000000, 2,
+                   [DESTINATION]))
+    assert e.value.status == 0x6D18
+
+
+def test_policy_fee(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+
+    # 0.001 GAS per transaction
+    with backend.exchange_async(
+            CLA, INS_SET_POLICY, P1_POLICY_SET, 0x00,
+            policy(POLICY_ASSET_GAS, 100000, 2000000, 2, [DESTINATION])):
+        navigate(firmware, navigator)
+
+    # 0.0001 GAS to the destination is within the cap, but the extra inputs
+    # burn 0.0017189 GAS as fee, so it is reviewed
+    load_attested_inputs(backend)
+    tx = spend_attested_inputs(10000)
+    sigDer = sign_tx(backend, firmware, navigator, tx + get_packed_path(),
+                     None, True)
+    sigLen = sigDer.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(tx, sigDer.data[:sigLen + 2], publicKey)
+
+    backend.exchange(CLA, INS_SET_POLICY, P1_POLICY_CLEAR, 0x00)
@@ -0,0 +1,46 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_GET_APP_CONFIGURATION,
+                   INS_GET_PUBLIC_KEY, INS_SIGN, MAX_APDU_SIZE, P1_LAST,
+                   P1_MORE, PATH_LEN, SIGDER_LEN_OFFSET, check_tx_nist256,
+                   get_public_key, navigate)
+from test_NEP5 import textToSign_00
+
+
+def test_session_read_only_instructions_keep_upload(backend, firmware,
+                                                    navigator):
+    first, last = textToSign_00[:MAX_APDU_SIZE], textToSign_00[MAX_APDU_SIZE:]
+    backend.exchange(CLA, INS_SIGN, P1_MORE, 0x00, first)
+
+    # read-only instructions in the middle of the upload, even malformed ones
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_GET_PUBLIC_KEY, 0x00, 0x00, bytes(12))
+    assert e.value.status == 0x6D09
+    backend.exchange(CLA, INS_GET_APP_CONFIGURATION)
+
+    # the upload goes on where it was
+    with backend.exchange_async(CLA, INS_SIGN, P1_LAST, 0x00, last):
+        navigate(firmware, navigator, None)
+    response = backend.last_async_response.data
+
+    sigLen = response[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], response[:sigLen + 2],
+                     publicKey)
@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_SIGN_BATCH, P1_BATCH_REVIEW,
+                   P1_BATCH_SIGNATURE, check_tx_nist256, get_packed_path,
+                   get_public_key, navigate, send_tx)
+from test_GAS_NEO import rawText_00, rawText_01
+
+# the script hash of the key at DEFAULT_PATH,
+# AJHeWQn2qKKqD4nBE82etebgT3GEM9HDRH
+CHANGE_SCRIPT_HASH = bytes.fromhex(
+    "1b91c31d768519e2bc30a2924578c85390d01e07")
+
+# rawText_00 sends 0.001 GAS and its change to
+# AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT, its last 20 bytes are the script hash
+# of the change output. sent back to the key, the change is not shown.
+rawText_change = rawText_00[:-20] + CHANGE_SCRIPT_HASH
+
+
+def test_sign_batch(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    transactions = [rawText_change, rawText_01]
+
+    # queue the transactions, each one gets its index in the batch
+    for ix, tx in enumerate(transactions):
+        response = send_tx(backend, INS_SIGN_BATCH, tx + get_packed_path())
+        assert response.data[0] == ix
+
+    # a single review for the whole batch, no snapshot comparison
+    with backend.exchange_async(CLA, INS_SIGN_BATCH, P1_BATCH_REVIEW, 0x00):
+        navigate(firmware, navigator)
+    assert backend.last_async_response.data[0] == len(transactions)
+
+    # then one signature per transaction
+    for ix, tx in enumerate(transactions):
+        sigDer = backend.exchange(CLA, INS_SIGN_BATCH, P1_BATCH_SIGNATURE, ix)
+        check_tx_nist256(tx, sigDer.data, publicKey)
+
+
+def test_sign_batch_hidden_output(backend, firmware, navigator):
+    # the batch review shows the first output only, a second output paying
+    # another address is refused instead of being signed unseen
+    with pytest.raises(ExceptionRAPDU) as e:
+        send_tx(backend, INS_SIGN_BATCH, rawText_00 + get_packed_path())
+    assert e.value.status == 0x6D22
+
+    # the refused transaction was not queued
+    response = send_tx(backend, INS_SIGN_BATCH, rawText_01 + get_packed_path())
+    assert response.data[0] == 0
@@ -0,0 +1,49 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_SIGN, P1_LAST, PATH_LEN,
+                   SIGDER_LEN_OFFSET, check_tx_nist256, get_public_key,
+                   serialize_extended, sign_tx)
+from test_NEP5 import textToSign_00
+
+
+def test_sign_extended_apdu(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+
+    # the transaction is longer than one extended part
+    response = sign_tx(backend,
+                       firmware,
+                       navigator,
+                       textToSign_00,
+                       None,
+                       True,
+                       extended=True).data
+
+    sigLen = response[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], response[:sigLen + 2],
+                     publicKey)
+
+
+def test_sign_extended_apdu_bad_length(backend):
+    apdu = serialize_extended(CLA, INS_SIGN, P1_LAST, 0x00, textToSign_00[:64])
+    # the length says one more byte than was sent
+    apdu = apdu[:5] + (64 + 1).to_bytes(2, "big") + apdu[7:]
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange_raw(apdu)
+    assert e.value.status == 0x6D1E
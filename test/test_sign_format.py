@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+from hashlib import sha256
+from ecdsa.curves import NIST256p
+from ecdsa.keys import VerifyingKey
+from ecdsa.util import sigdecode_string
+from utils import (CLA, DEFAULT_PATH, INS_SET_SIGN_FORMAT, PATH_LEN,
+                   SIGN_FORMAT_LEGACY, SIGN_FORMAT_RAW, SIGN_FORMAT_TXID,
+                   SIGN_FORMAT_WITNESS, get_public_key, sign_tx)
+from test_GAS_NEO import textToSign_01
+
+RAW_SIG_LEN = 64
+WITNESS_LEN = 102
+
+
+def test_sign_format(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)
+    tx = textToSign_01[:-PATH_LEN]
+
+    backend.exchange(CLA, INS_SET_SIGN_FORMAT,
+                     SIGN_FORMAT_RAW | SIGN_FORMAT_TXID | SIGN_FORMAT_WITNESS,
+                     0x00)
+    response = sign_tx(backend, firmware, navigator, textToSign_01, None,
+                       True).data
+    assert len(response) == RAW_SIG_LEN + WITNESS_LEN + 32
+
+    # r||s signature
+    signature = response[:RAW_SIG_LEN]
+    pk = VerifyingKey.from_string(publicKey[1:],
+                                  curve=NIST256p,
+                                  hashfunc=sha256)
+    assert pk.verify(signature=signature,
+                     data=tx,
+                     hashfunc=sha256,
+                     sigdecode=sigdecode_string) is True
+
+    # witness: invocation script, then verification script
+    compressed = bytes([0x03 if publicKey[64] & 1 else 0x02]) + publicKey[1:33]
+    witness = response[RAW_SIG_LEN:RAW_SIG_LEN + WITNESS_LEN]
+    assert witness == bytes([0x41, 0x40]) + signature + bytes(
+        [0x23, 0x21]) + compressed + bytes([0xAC])
+
+    # transaction id
+    assert response[RAW_SIG_LEN + WITNESS_LEN:] == sha256(
+        sha256(tx).digest()).digest()
+
+    backend.exchange(CLA, INS_SET_SIGN_FORMAT, SIGN_FORMAT_LEGACY, 0x00)
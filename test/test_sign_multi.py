@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+from ragger.bip import pack_derivation_path
+from utils import (DEFAULT_PATH, INS_SIGN_MULTI, check_tx_nist256,
+                   get_public_key, sign_tx)
+
+SECOND_PATH: str = "m/44'/888'/0'/0/1"
+
+# sending 1 NEO, signed by two different addresses
+rawText_00 = bytearray.fromhex(
+    "800000018d121f4bc2bf104e547e85d680780fe629c2b3ce89ac73e0ff02feb572bb98e00000019b7cffdaa674beae0f930ebe6085af9093e5fe56b34a5c220ccdcf6efc336fc500e1f5050000000013354f4f5d3f989a221c794271e0bb2471c2735e"
+)
+
+
+def test_sign_multi(backend, firmware, navigator):
+    paths = [DEFAULT_PATH, SECOND_PATH]
+    publicKeys = [get_public_key(backend, path)[1:] for path in paths]
+
+    textToSign = rawText_00
+    for path in paths:
+        textToSign += pack_derivation_path(path)[1:]
+
+    # no snapshot comparison, the review screens are the ones of test_send_neo
+    response = sign_tx(backend,
+                       firmware,
+                       navigator,
+                       textToSign,
+                       None,
+                       True,
+                       ins=INS_SIGN_MULTI,
+                       p2=len(paths))
+
+    # one DER signature per path, in the order of the paths
+    offset = 0
+    for publicKey in publicKeys:
+        sigLen = response.data[offset + 1] + 2
+        check_tx_nist256(rawText_00, response.data[offset:offset + sigLen],
+                         publicKey)
+        offset += sigLen
+    assert offset == len(response.data)
@@ -0,0 +1,34 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+from utils import (DEFAULT_PATH, PATH_LEN, SIGDER_LEN_OFFSET, check_tx_nist256,
+                   get_public_key, sign_tx)
+from test_GAS_NEO import textToSign_00
+
+
+def test_sign_retry(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+
+    first = sign_tx(backend, firmware, navigator, textToSign_00, None, True)
+
+    # the same transaction again, as after a lost response: no second review
+    retry = sign_tx(backend, firmware, navigator, textToSign_00, None, False)
+    assert retry.data == first.data
+
+    sigLen = retry.data[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], retry.data[:sigLen + 2],
+                     publicKey)
@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import binascii
+import struct
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_SIGN, P1_LAST, P1_MORE, P1_SEQUENCED,
+                   PATH_LEN, SIGDER_LEN_OFFSET, check_tx_nist256,
+                   get_public_key, navigate)
+from test_NEP5 import textToSign_00
+
+PART_LEN = 100
+CRC_INIT = 0xFFFF
+
+
+def get_parts(tx):
+    parts = []
+    crc = CRC_INIT
+    for offset in range(0, len(tx), PART_LEN):
+        chunk = tx[offset:offset + PART_LEN]
+        crc = binascii.crc_hqx(chunk, crc)
+        parts.append(struct.pack(">HH", len(parts), crc) + chunk)
+    return parts
+
+
+def send_part(backend, parts, seq):
+    return backend.exchange(CLA, INS_SIGN, P1_MORE | P1_SEQUENCED, 0x00,
+                            parts[seq])
+
+
+def send_last_part(backend, firmware, navigator, parts):
+    with backend.exchange_async(CLA, INS_SIGN, P1_LAST | P1_SEQUENCED, 0x00,
+                                parts[-1]):
+        navigate(firmware, navigator, None)
+    return backend.last_async_response
+
+
+def test_sign_sequenced_resume(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    parts = get_parts(textToSign_00)
+    assert len(parts) == 3
+
+    send_part(backend, parts, 0)
+
+    # part 1 is lost, part 2 is rejected with the part expected
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_SIGN, P1_LAST | P1_SEQUENCED, 0x00, parts[2])
+    assert e.value.status == 0x6D1F
+    assert e.value.data == struct.pack(">H", 1)
+
+    # the upload resumes from part 1
+    send_part(backend, parts, 1)
+    response = send_last_part(backend, firmware, navigator, parts).data
+
+    sigLen = response[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], response[:sigLen + 2],
+                     publicKey)
+
+
+def test_sign_sequenced_bad_checksum(backend):
+    parts = get_parts(textToSign_00)
+    send_part(backend, parts, 0)
+
+    corrupted = bytearray(parts[1])
+    corrupted[-1] ^= 0x01
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_SIGN, P1_MORE | P1_SEQUENCED, 0x00,
+                         bytes(corrupted))
+    assert e.value.status == 0x6D1F
+    assert e.value.data == struct.pack(">H", 1)
+
+    # the good part is still expected
+    send_part(backend, parts, 1)
@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_GET_APP_CONFIGURATION,
+                   INS_GET_PUBLIC_KEY, get_public_key)
+
+# only in builds with STACK_PROFILE=1
+INS_GET_STACK_PROFILE = 0xE0
+P1_STACK_PROFILE_RESET = 0x01
+
+
+def get_stack_profile(backend, p1=0x00):
+    try:
+        response = backend.exchange(CLA, INS_GET_STACK_PROFILE, p1).data
+    except ExceptionRAPDU as e:
+        if e.status == 0x6D00:
+            pytest.skip("the app is not built with STACK_PROFILE=1")
+        raise
+    stack_size = int.from_bytes(response[0:2], "big")
+    peaks = {
+        response[ix]: int.from_bytes(response[ix + 1:ix + 3], "big")
+        for ix in range(2, len(response), 3)
+    }
+    return stack_size, peaks
+
+
+def test_stack_profile(backend):
+    get_stack_profile(backend, P1_STACK_PROFILE_RESET)
+    get_public_key(backend, DEFAULT_PATH)
+    backend.exchange(CLA, INS_GET_APP_CONFIGURATION)
+
+    stack_size, peaks = get_stack_profile(backend, P1_STACK_PROFILE_RESET)
+    # deriving and showing a key takes more stack than reading the configuration
+    assert 0 < peaks[INS_GET_APP_CONFIGURATION] < peaks[
+        INS_GET_PUBLIC_KEY] < stack_size
+
+    # the marks were cleared once sent
+    _, peaks = get_stack_profile(backend)
+    assert peaks[INS_GET_PUBLIC_KEY] == 0
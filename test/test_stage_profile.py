@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import CLA, sign_tx
+from test_GAS_NEO import rawText_00, textToSign_00
+
+# only in builds with STAGE_PROFILE=1
+INS_GET_STAGE_PROFILE = 0xE2
+STAGE_PARSE = 0
+STAGE_ADDRESS_HASH = 1
+STAGE_BASE_X = 2
+STAGE_DERIVE = 3
+STAGE_SIGN = 4
+STAGE_REVIEW = 5
+
+
+def get_stage_profile(backend):
+    try:
+        response = backend.exchange(CLA, INS_GET_STAGE_PROFILE).data
+    except ExceptionRAPDU as e:
+        if e.status == 0x6D00:
+            pytest.skip("the app is not built with STAGE_PROFILE=1")
+        raise
+    return {
+        response[ix]: (int.from_bytes(response[ix + 1:ix + 5], "big"),
+                       int.from_bytes(response[ix + 5:ix + 9], "big"))
+        for ix in range(0, len(response), 9)
+    }
+
+
+def test_stage_profile(backend, firmware, navigator):
+    get_stage_profile(backend)
+    sign_tx(backend, firmware, navigator, textToSign_00, None, True)
+
+    stages = get_stage_profile(backend)
+    assert stages[STAGE_PARSE][0] == 1
+    assert stages[STAGE_PARSE][1] >= len(rawText_00)
+    # both outputs show an address
+    assert stages[STAGE_ADDRESS_HASH][0] >= 2
+    assert stages[STAGE_BASE_X][0] >= 2
+    assert stages[STAGE_DERIVE][0] >= 1
+    assert stages[STAGE_SIGN] == (1, 32)
+    assert stages[STAGE_REVIEW][0] == 1
+
+    # the counters were cleared once sent
+    stages = get_stage_profile(backend)
+    assert all(calls == 0 for calls, _ in stages.values())
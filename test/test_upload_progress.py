@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+import struct
+import pytest
+from ragger.error import ExceptionRAPDU
+from utils import (CLA, DEFAULT_PATH, INS_SIGN, P1_LAST, P1_MORE,
+                   P1_TOTAL_LENGTH, PATH_LEN, SIGDER_LEN_OFFSET,
+                   check_tx_nist256, get_public_key, navigate)
+from test_NEP5 import textToSign_00
+
+# small parts, so the progress is shown more than once
+PART_LEN = 50
+MAX_TX_RAW_LENGTH = 1024
+# the progress is drawn again every few parts, as in src/ui.h
+PROGRESS_UPDATE_PARTS = 4
+
+
+def test_upload_progress(backend, firmware, navigator):
+    publicKey = get_public_key(backend, DEFAULT_PATH)[1:]
+    parts = [
+        textToSign_00[offset:offset + PART_LEN]
+        for offset in range(0, len(textToSign_00), PART_LEN)
+    ]
+    assert len(parts) > 4
+
+    # the first part gives the total length
+    backend.exchange(CLA, INS_SIGN, P1_MORE | P1_TOTAL_LENGTH, 0x00,
+                     struct.pack(">H", len(textToSign_00)) + parts[0])
+    for part in parts[1:-1]:
+        backend.exchange(CLA, INS_SIGN, P1_MORE, 0x00, part)
+
+    # the progress stays on screen between the parts, as last drawn
+    last_drawn_ix = (len(parts) - 2) // PROGRESS_UPDATE_PARTS
+    last_drawn_ix *= PROGRESS_UPDATE_PARTS
+    received = min((last_drawn_ix + 1) * PART_LEN, len(textToSign_00))
+    percent = min(received * 100 // len(textToSign_00), 99)
+    backend.wait_for_text_on_screen("Receiving")
+    assert backend.compare_screen_with_text(f".*{percent}%")
+
+    # the review takes over from the progress
+    with backend.exchange_async(CLA, INS_SIGN, P1_LAST, 0x00, parts[-1]):
+        navigate(firmware, navigator, None)
+    response = backend.last_async_response.data
+
+    sigLen = response[SIGDER_LEN_OFFSET]
+    check_tx_nist256(textToSign_00[:-PATH_LEN], response[:sigLen + 2],
+                     publicKey)
+
+
+def test_upload_progress_total_length_after_first_part(backend):
+    backend.exchange(CLA, INS_SIGN, P1_MORE, 0x00, textToSign_00[:PART_LEN])
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_SIGN, P1_MORE | P1_TOTAL_LENGTH, 0x00,
+                         struct.pack(">H", len(textToSign_00)) +
+                         textToSign_00[PART_LEN:2 * PART_LEN])
+    assert e.value.status == 0x6A86
+
+
+def test_upload_progress_total_length_too_long(backend):
+    with pytest.raises(ExceptionRAPDU) as e:
+        backend.exchange(CLA, INS_SIGN, P1_MORE | P1_TOTAL_LENGTH, 0x00,
+                         struct.pack(">H", MAX_TX_RAW_LENGTH + 1) +
+                         textToSign_00[:PART_LEN])
+    assert e.value.status == 0x6D08
@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tests
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+"""Builds valid Neo transactions of any shape for the benchmarks: a number of
+outputs, attributes, inputs and claims, and a script size for invocations.
+
+usage: tx_generator.py [--type contract|claim|invocation] [--outputs N]
+                       [--attributes N] [--inputs N] [--claims N]
+                       [--script-size N]
+prints the transaction in hex, without the BIP44 path the app expects after it.
+"""
+import argparse
+import struct
+
+TX_CLAIM: int = 0x02
+TX_CONTRACT: int = 0x80
+TX_INVOCATION: int = 0xD1
+TX_TYPES = {
+    "contract": TX_CONTRACT,
+    "claim": TX_CLAIM,
+    "invocation": TX_INVOCATION
+}
+
+# an attribute of usage REMARK, followed by the length of its data
+ATTR_REMARK: int = 0xF0
+ATTR_REMARK_LEN: int = 16
+
+NEO_ASSET_ID = bytes.fromhex(
+    "9b7cffdaa674beae0f930ebe6085af9093e5fe56b34a5c220ccdcf6efc336fc5")
+GAS_ASSET_ID = bytes.fromhex(
+    "e72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60")
+DESTINATION = bytes.fromhex("13354f4f5d3f989a221c794271e0bb2471c2735e")
+
+# the app counts are one byte, below the 0xFD of longer varints
+MAX_COUNT: int = 0xFC
+# raw_tx holds the transaction and the 20 bytes of the BIP44 path
+MAX_TX_LEN: int = 1024 - 20
+
+
+def var_count(count: int) -> bytes:
+    if count > MAX_COUNT:
+        raise ValueError(f"{count} does not fit in a one byte count")
+    return bytes([count])
+
+
+def coin_reference(ix: int) -> bytes:
+    """A previous transaction hash and output index, distinct for each ix."""
+    return struct.pack("<I", ix) * 8 + struct.pack("<H", ix)
+
+
+def output(ix: int) -> bytes:
+    """Alternately 1 NEO and 0.001 GAS to DESTINATION."""
+    if ix % 2 == 0:
+        return NEO_ASSET_ID + struct.pack("<Q", 100000000) + DESTINATION
+    return GAS_ASSET_ID + struct.pack("<Q", 100000) + DESTINATION
+
+
+def attribute(ix: int) -> bytes:
+    return bytes([ATTR_REMARK, ATTR_REMARK_LEN]) + bytes(
+        [ix & 0xFF]) * ATTR_REMARK_LEN
+
+
+def build_tx(tx_type: int = TX_CONTRACT,
+             outputs: int = 1,
+             attributes: int = 0,
+             inputs: int = 1,
+             claims: int = 0,
+             script_size: int = 0) -> bytes:
+    """The transaction, raises ValueError if it does not fit in the app."""
+    tx = bytearray()
+    if tx_type == TX_INVOCATION:
+        # version 1 adds the GAS the invocation may use
+        tx += bytes([tx_type, 0x01])
+        tx += var_count(script_size) + bytes([0x51]) * script_size
+        tx += struct.pack("<Q", 0)
+    elif tx_type == TX_CLAIM:
+        tx += bytes([tx_type, 0x00])
+        tx += var_count(claims)
+        for ix in range(claims):
+            tx += coin_reference(ix)
+    else:
+        tx += bytes([tx_type, 0x00])
+
+    tx += var_count(attributes)
+    for ix in range(attributes):
+        tx += attribute(ix)
+    tx += var_count(inputs)
+    for ix in range(inputs):
+        tx += coin_reference(MAX_COUNT + 1 + ix)
+    tx += var_count(outputs)
+    for ix in range(outputs):
+        tx += output(ix)
+
+    if len(tx) > MAX_TX_LEN:
+        raise ValueError(f"{len(tx)} bytes do not fit in {MAX_TX_LEN}")
+    return bytes(tx)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--type", choices=TX_TYPES, default="contract")
+    parser.add_argument("--outputs", type=int, default=1)
+    parser.add_argument("--attributes", type=int, default=0)
+    parser.add_argument("--inputs", type=int, default=1)
+    parser.add_argument("--claims", type=int, default=0)
+    parser.add_argument("--script-size", type=int, default=0)
+    args = parser.parse_args()
+    print(
+        build_tx(TX_TYPES[args.type], args.outputs, args.attributes,
+                 args.inputs, args.claims, args.script_size).hex())
+
+
+if __name__ == "__main__":
+    main()
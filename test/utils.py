@@ -11,11 +11,36 @@ from ragger.navigator import NavInsID
 CLA: int = 0x80
 INS_SIGN: int = 0x02
 INS_GET_PUBLIC_KEY: int = 0x04
+INS_GET_APP_CONFIGURATION: int = 0x06
 INS_GET_SIGNED_PUBLIC_KEY: int = 0x08
+INS_SIGN_MULTI: int = 0x0A
+INS_SIGN_BATCH: int = 0x0C
+INS_SET_POLICY: int = 0x0E
+INS_SET_SIGN_FORMAT: int = 0x10
+INS_ATTEST_INPUT: int = 0x12
+INS_DRY_RUN: int = 0x14
 P1_LAST: int = 0x80
 P1_MORE: int = 0x00
+P1_SEQUENCED: int = 0x40
+P1_TOTAL_LENGTH: int = 0x20
+P1_BATCH_REVIEW: int = 0x01
+P1_BATCH_SIGNATURE: int = 0x02
+P1_POLICY_SET: int = 0x00
+P1_POLICY_CLEAR: int = 0x01
+POLICY_ASSET_NEO: int = 0x01
+POLICY_ASSET_GAS: int = 0x02
+SIGN_FORMAT_LEGACY: int = 0x00
+SIGN_FORMAT_RAW: int = 0x01
+SIGN_FORMAT_TXID: int = 0x02
+SIGN_FORMAT_WITNESS: int = 0x04
+P1_ATTEST_LOAD: int = 0x01
+P1_ATTEST_CLEAR: int = 0x02
+P2_ATTEST_FIRST: int = 0x01
+P1_DRY_RUN_OUTPUTS: int = 0x01
 DEFAULT_PATH: str = "m/44'/888'/0'/0/0"
 MAX_APDU_SIZE: int = 0xFF
+# an extended length part, with its 7 bytes header, fits any device's APDU buffer
+MAX_EXTENDED_APDU_SIZE: int = 0xF8
 SIGDER_LEN_OFFSET: int = 1
 SIGNED_KEY_SIG_OFFSET: int = 65
 PATH_LEN: int = 20
@@ -102,22 +127,60 @@ def navigate(firmware, navigator, snappath: Path = None):
                                                   snappath)
 
 
-def sign_tx(backend, firmware, navigator, tx, path, do_navigate):
+def serialize_extended(cla: int,
+                       ins: int,
+                       p1: int = 0,
+                       p2: int = 0,
+                       cdata: bytes = b"") -> bytes:
+    header: bytes = struct.pack(">BBBBBH", cla, ins, p1, p2, 0x00,
+                                len(cdata))
+    return header + cdata
+
+
+def sign_tx(backend,
+            firmware,
+            navigator,
+            tx,
+            path,
+            do_navigate,
+            ins=INS_SIGN,
+            p2=0x00,
+            extended=False):
+    max_size = MAX_EXTENDED_APDU_SIZE if extended else MAX_APDU_SIZE
     offset = 0
     while offset != len(tx):
-        if (len(tx) - offset) > MAX_APDU_SIZE:
-            chunk = tx[offset:offset + MAX_APDU_SIZE]
+        if (len(tx) - offset) > max_size:
+            chunk = tx[offset:offset + max_size]
         else:
             chunk = tx[offset:]
         if (offset + len(chunk)) == len(tx):
-            with backend.exchange_async(CLA, INS_SIGN, P1_LAST, 0x00, chunk):
-                if do_navigate:
-                    navigate(firmware, navigator, path)
-                pass
+            if extended:
+                apdu = serialize_extended(CLA, ins, P1_LAST, p2, chunk)
+                with backend.exchange_async_raw(apdu):
+                    if do_navigate:
+                        navigate(firmware, navigator, path)
+            else:
+                with backend.exchange_async(CLA, ins, P1_LAST, p2, chunk):
+                    if do_navigate:
+                        navigate(firmware, navigator, path)
+                    pass
             response = backend.last_async_response
+        elif extended:
+            backend.exchange_raw(
+                serialize_extended(CLA, ins, P1_MORE, 0x00, chunk))
         else:
-            backend.exchange(CLA, INS_SIGN, P1_MORE, 0x00, chunk)
+            backend.exchange(CLA, ins, P1_MORE, 0x00, chunk)
+        offset += len(chunk)
+    return response
+
+
+def send_tx(backend, ins, tx):
+    offset = 0
+    while offset != len(tx):
+        chunk = tx[offset:offset + MAX_APDU_SIZE]
         offset += len(chunk)
+        p1 = P1_LAST if offset == len(tx) else P1_MORE
+        response = backend.exchange(CLA, ins, p1, 0x00, chunk)
     return response
 
 
@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+# *******************************************************************************
+# *   NEO tools
+# *   (c) 2023 Ledger
+# *
+# *  Licensed under the Apache License, Version 2.0 (the "License");
+# *  you may not use this file except in compliance with the License.
+# *  You may obtain a copy of the License at
+# *
+# *      http://www.apache.org/licenses/LICENSE-2.0
+# *
+# *  Unless required by applicable law or agreed to in writing, software
+# *  distributed under the License is distributed on an "AS IS" BASIS,
+# *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# *  See the License for the specific language governing permissions and
+# *  limitations under the License.
+# ********************************************************************************
+"""Worst case stack of each instruction, from the stack frames the compiler writes to .su files
+with -fstack-usage, clang and gcc alike, and the calls of the disassembled objects. Run by
+`make stack_report`."""
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+FRAME = re.compile(r'^(.*)\t(\d+)\t([a-z,]+)$')
+LABEL = re.compile(r'^[0-9a-f]+ <([^>]+)>:$')
+RELOCATION = re.compile(r'^\s*[0-9a-f]+:\s+(R_\w+)\s+(\S+)$')
+INSTRUCTION = re.compile(r'^\s*[0-9a-f]+:\s+(.*)$')
+INDIRECT = re.compile(r'^(blx\s+(r\d+|ip|lr)\b|callq?\s+\*)')
+ADDEND = re.compile(r'[+-]0x[0-9a-f]+$')
+TABLE = re.compile(r'apdu_instructions\[\] = \{(.*?)\n\};', re.DOTALL)
+ENTRY = re.compile(r'\{(INS_\w+),.*?(\w+)\}', re.DOTALL)
+
+# the relocations of calls and tail calls, arm and thumb, and x86-64 for host builds.
+CALLS = {
+    "R_ARM_CALL", "R_ARM_JUMP24", "R_ARM_THM_CALL", "R_ARM_THM_JUMP24", "R_ARM_THM_JUMP19",
+    "R_X86_64_PLT32"
+}
+
+# the calls from the app's entry to the instruction handlers.
+DISPATCH_PATH = ["main", "neo_main", "dispatch_apdu"]
+
+# the functions the UI calls back once the user approves, which sign and send the response.
+UI_ENTRIES = ["sign_tx_and_send_response", "sign_tx_from_cache"]
+
+
+def read_frames(obj_dir):
+    """the frame of each function, a .su line is <file>:<line>[:<column>]:<function>, the frame
+    size and its kind."""
+    frames = {}
+    dynamic = set()
+    for su in sorted(Path(obj_dir).rglob("*.su")):
+        for line in su.read_text().splitlines():
+            frame = FRAME.match(line)
+            if not frame:
+                continue
+            name = frame.group(1).rsplit(":", 1)[-1]
+            frames[name] = max(frames.get(name, 0), int(frame.group(2)))
+            if "dynamic" in frame.group(3):
+                dynamic.add(name)
+    return frames, dynamic
+
+
+def callee_name(symbol):
+    """the function a call relocation points to, calls to static functions may point to their
+    section."""
+    name = ADDEND.sub("", symbol)
+    return name[len(".text."):] if name.startswith(".text.") else name
+
+
+def read_calls(obj_dir, objdump):
+    """the functions each function calls, __indirect_call stands for the calls through a
+    register."""
+    calls = {}
+    for obj in sorted(Path(obj_dir).rglob("*.o")):
+        listing = subprocess.run([objdump, "-d", "-r", "--no-show-raw-insn",
+                                  str(obj)],
+                                 check=True,
+                                 capture_output=True,
+                                 text=True).stdout
+        function = None
+        for line in listing.splitlines():
+            label = LABEL.match(line)
+            if label:
+                # $t, $a and $d mark code and data inside a function.
+                if not label.group(1).startswith("$"):
+                    function = label.group(1)
+                continue
+            if function is None:
+                continue
+            relocation = RELOCATION.match(line)
+            if relocation:
+                if relocation.group(1) in CALLS:
+                    calls.setdefault(function, set()).add(callee_name(relocation.group(2)))
+                continue
+            instruction = INSTRUCTION.match(line)
+            if instruction and INDIRECT.match(instruction.group(1)):
+                calls.setdefault(function, set()).add("__indirect_call")
+    return calls
+
+
+def worst_case(name, frames, calls, memo, path):
+    """returns the deepest stack from name and the calls that reach it, and whether the result is
+    a bound: recursion and indirect calls are not followed."""
+    if name in memo:
+        return memo[name]
+    if name in path:
+        return 0, [name + " (recursion)"], False
+    bounded = name != "__indirect_call"
+    deepest, deepest_calls = 0, []
+    for callee in sorted(calls.get(name, ())):
+        size, callee_calls, callee_bounded = worst_case(callee, frames, calls, memo,
+                                                        path | {name})
+        bounded = bounded and callee_bounded
+        if size > deepest:
+            deepest, deepest_calls = size, callee_calls
+    memo[name] = (frames.get(name, 0) + deepest, [name] + deepest_calls, bounded)
+    return memo[name]
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit("usage: stack_report.py <object directory> <src/main.c> <objdump>")
+    frames, dynamic = read_frames(sys.argv[1])
+    if not frames:
+        sys.exit("no .su files, build with STACK_USAGE=1")
+    calls = read_calls(sys.argv[1], sys.argv[3])
+    table = TABLE.search(Path(sys.argv[2]).read_text())
+    handlers = [(ins, handler) for ins, handler in ENTRY.findall(table.group(1))]
+
+    prefix = sum(frames.get(name, 0) for name in DISPATCH_PATH)
+    memo = {}
+    print(f"{'instruction':<28}{'bytes':>6}  deepest calls")
+    for label, root, base in ([(ins, handler, prefix) for ins, handler in handlers] +
+                              [(entry, entry, 0) for entry in UI_ENTRIES]):
+        size, path, bounded = worst_case(root, frames, calls, memo, frozenset())
+        note = "" if bounded else " (at least, indirect call or recursion)"
+        print(f"{label:<28}{base + size:>6}  {' > '.join(path)}{note}")
+    if dynamic:
+        print("dynamic frames, not bounded: " + ", ".join(sorted(dynamic)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** benchmark of the parser and the encoders of neo.c, built for the host. run it with the number
+ * of iterations, 100000 by default. */
+
+#include <stdlib.h>
+#include <time.h>
+#include "neo.h"
+#include "tx_vectors.h"
+
+/** nanoseconds of the monotonic clock. */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/** parses the transaction iterations times, and reports transactions per second and nanoseconds
+ * per output. */
+static void bench_display_tx_desc(const char *name, const char *hex, unsigned int iterations) {
+    load_raw_tx(hex);
+    unsigned int len = raw_tx_len;
+    unsigned int outputs = 0;
+
+    uint64_t start = now_ns();
+    for (unsigned int ix = 0; ix < iterations; ix++) {
+        raw_tx_ix = 0;
+        raw_tx_len = len;
+        if (display_tx_desc() != SW_OK) {
+            fprintf(stderr, "%s does not parse\n", name);
+            exit(EXIT_FAILURE);
+        }
+        outputs += tx_summary.num_tx_outs;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("display_tx_desc %-12s %10.0f tx/s %8.1f ns/output\n",
+           name,
+           (double) iterations * 1e9 / (double) elapsed,
+           (double) elapsed / (double) outputs);
+}
+
+static void bench_to_address(unsigned int iterations) {
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    char address[ADDRESS_BASE58_LEN + 1];
+    from_hex(SCRIPT_HASH_AHXSMB, script_hash, sizeof(script_hash));
+
+    uint64_t start = now_ns();
+    for (unsigned int ix = 0; ix < iterations; ix++) {
+        script_hash[0] = ix;
+        if (to_address(address, sizeof(address), script_hash) != SW_OK) {
+            fprintf(stderr, "to_address failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("to_address                   %8.1f ns/call\n", (double) elapsed / iterations);
+}
+
+static void bench_to_base10_100m(unsigned int iterations) {
+    unsigned char value[VALUE_LEN];
+    char text[MAX_TX_TEXT_WIDTH + 2];
+
+    uint64_t start = now_ns();
+    for (unsigned int ix = 0; ix < iterations; ix++) {
+        uint64_to_value(value, 100000000ULL + ix);
+        if (to_base10_100m(text, value, sizeof(text)) != SW_OK) {
+            fprintf(stderr, "to_base10_100m failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("to_base10_100m               %8.1f ns/call\n", (double) elapsed / iterations);
+}
+
+int main(int argc, char **argv) {
+    unsigned int iterations = 100000;
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bench_display_tx_desc("send GAS", TX_SEND_GAS, iterations);
+    bench_display_tx_desc("send NEO", TX_SEND_NEO, iterations);
+    bench_display_tx_desc("claim GAS", TX_CLAIM_GAS, iterations);
+    bench_to_address(iterations);
+    bench_to_base10_100m(iterations);
+    return EXIT_SUCCESS;
+}
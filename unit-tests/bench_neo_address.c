@@ -0,0 +1,68 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** benchmark of the batches of neo_address against the device code of neo.c, on one core. run it
+ * with the number of keys, 1000000 by default. */
+
+#include <stdlib.h>
+#include <time.h>
+#include "neo.h"
+#include "neo_address.h"
+
+/** the keys of a call to neo_addresses. */
+#define BATCH_LEN 4096
+
+/** nanoseconds of the monotonic clock. */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static void report(const char *name, unsigned int count, uint64_t elapsed) {
+    printf("%-20s %12.0f addresses/s/core %8.1f ns/address\n",
+           name,
+           (double) count * 1e9 / (double) elapsed,
+           (double) elapsed / (double) count);
+}
+
+int main(int argc, char **argv) {
+    unsigned int count = 1000000;
+    if (argc > 1) {
+        count = strtoul(argv[1], NULL, 10);
+    }
+    if (count == 0) {
+        fprintf(stderr, "usage: %s [keys]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static unsigned char public_keys[BATCH_LEN][NEO_PUBLIC_KEY_LEN];
+    static char addresses[BATCH_LEN][NEO_ADDRESS_LEN + 1];
+    for (unsigned int ix = 0; ix < BATCH_LEN; ix++) {
+        public_keys[ix][0] = 0x04;
+        for (unsigned int byte_ix = 1; byte_ix < NEO_PUBLIC_KEY_LEN; byte_ix++) {
+            public_keys[ix][byte_ix] = (ix * 31) + (byte_ix * 7);
+        }
+    }
+
+    uint64_t start = now_ns();
+    for (unsigned int done = 0; done < count; done += BATCH_LEN) {
+        unsigned int batch = (count - done < BATCH_LEN) ? count - done : BATCH_LEN;
+        public_keys[0][1] = done;
+        neo_addresses(public_keys[0], batch, addresses[0]);
+    }
+    report("neo_addresses", count, now_ns() - start);
+
+    start = now_ns();
+    for (unsigned int ix = 0; ix < count; ix++) {
+        unsigned char script_hash[SCRIPT_HASH_LEN];
+        public_key_to_script_hash(public_keys[ix % BATCH_LEN], script_hash);
+        if (to_address(addresses[ix % BATCH_LEN], NEO_ADDRESS_LEN + 1, script_hash) != SW_OK) {
+            fprintf(stderr, "to_address failed\n");
+            return EXIT_FAILURE;
+        }
+    }
+    report("device code", count, now_ns() - start);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,11 @@
+# decodes INPUT with DECODE, on three workers taking two transactions at a time so that the order
+# of the output is checked, and compares the output with EXPECTED.
+execute_process(COMMAND ${DECODE} -j 3 -c 2 -o ${OUTPUT} ${INPUT} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${DECODE} failed: ${result}")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${OUTPUT} is not ${EXPECTED}")
+endif()
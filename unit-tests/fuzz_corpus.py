@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Writes the seed corpus of the fuzz target, one file per byte string the tests in test/ write
+in hex: the transactions they sign, and the asset ids and script hashes the encoders also take.
+A byte string is a bytearray.fromhex() or bytes.fromhex() of literal strings, joined with +.
+
+usage: fuzz_corpus.py <test directory> <corpus directory>
+"""
+
+import ast
+import hashlib
+import sys
+from pathlib import Path
+
+# the shortest input the target does more with than reject it: a script hash.
+MIN_INPUT_LEN = 20
+
+
+def literal_text(node):
+    """Returns the string of node, literal strings joined with +, or None."""
+    if isinstance(node, ast.Constant) and isinstance(node.value, str):
+        return node.value
+    if isinstance(node, ast.BinOp) and isinstance(node.op, ast.Add):
+        left = literal_text(node.left)
+        right = literal_text(node.right)
+        if (left is not None) and (right is not None):
+            return left + right
+    return None
+
+
+def fromhex_literals(path):
+    """Yields the bytes of each fromhex() call on a literal string in the module at path."""
+    tree = ast.parse(path.read_text(), filename=str(path))
+    for node in ast.walk(tree):
+        if not (isinstance(node, ast.Call) and isinstance(node.func, ast.Attribute)
+                and node.func.attr == "fromhex" and len(node.args) == 1):
+            continue
+        text = literal_text(node.args[0])
+        if text is not None:
+            yield bytes.fromhex(text)
+
+
+def main(test_dir, corpus_dir):
+    corpus_dir.mkdir(parents=True, exist_ok=True)
+    names = set()
+    for path in sorted(test_dir.glob("*.py")):
+        for data in fromhex_literals(path):
+            if len(data) < MIN_INPUT_LEN:
+                continue
+            # named after their contents, the same bytes in two modules are one input.
+            name = hashlib.sha1(data).hexdigest()
+            (corpus_dir / name).write_bytes(data)
+            names.add(name)
+    print(f"{len(names)} inputs written to {corpus_dir}")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(Path(sys.argv[1]), Path(sys.argv[2]))
@@ -0,0 +1,115 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** fuzz target of the parser and the encoders of neo.c, built for the host. the input is a raw
+ * transaction, as the last part of an upload leaves it in raw_tx. its first bytes are also
+ * encoded as an amount and as a script hash. */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "neo.h"
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FUZZ_ASAN
+#endif
+#endif
+#ifdef __SANITIZE_ADDRESS__
+#define FUZZ_ASAN
+#endif
+
+#ifdef FUZZ_ASAN
+#include <sanitizer/asan_interface.h>
+/** the parser must not read raw_tx past raw_tx_len, so the rest of raw_tx is poisoned. */
+#define POISON_RAW_TX(len) ASAN_POISON_MEMORY_REGION(raw_tx + (len), sizeof(raw_tx) - (len))
+#define UNPOISON_RAW_TX() ASAN_UNPOISON_MEMORY_REGION(raw_tx, sizeof(raw_tx))
+#else
+#define POISON_RAW_TX(len)
+#define UNPOISON_RAW_TX()
+#endif
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/** puts the globals the parser uses back as the app starts, so that a run does not depend on the
+ * ones before it in the same process. */
+static void fuzz_reset(void) {
+    UNPOISON_RAW_TX();
+    memset(raw_tx, 0, sizeof(raw_tx));
+    raw_tx_ix = 0;
+    raw_tx_len = 0;
+    memset(tx_desc, 0, sizeof(tx_desc));
+    memset(address58, 0, sizeof(address58));
+    curr_scr_ix = 0;
+    max_scr_ix = 0;
+    memset(&session, 0, sizeof(session));
+    memset(&tx_summary, 0, sizeof(tx_summary));
+}
+
+/** encodes the first bytes of the input as an amount, into buffers of every length up to the
+ * longest text. each buffer is on the heap and left as malloc returns it, so that a write past its
+ * length is reported, and a text must end in a null of its own. */
+static void fuzz_to_base10_100m(const uint8_t *data, size_t size) {
+    unsigned char value[VALUE_LEN];
+    if (size < VALUE_LEN) {
+        return;
+    }
+    memmove(value, data, VALUE_LEN);
+    for (unsigned int dest_len = 1; dest_len <= MAX_TX_TEXT_WIDTH + 2; dest_len++) {
+        char *text = malloc(dest_len);
+        if (text == NULL) {
+            abort();
+        }
+        if ((to_base10_100m(text, value, dest_len) == SW_OK) &&
+            (memchr(text, '\0', dest_len) == NULL)) {
+            __builtin_trap();
+        }
+        free(text);
+    }
+}
+
+/** encodes the first bytes of the input as a script hash. */
+static void fuzz_to_address(const uint8_t *data, size_t size) {
+    char address[ADDRESS_BASE58_LEN + 1];
+    if (size < SCRIPT_HASH_LEN) {
+        return;
+    }
+    memset(address, '\0', sizeof(address));
+    if ((to_address(address, sizeof(address), data) != SW_OK) || (address[0] != 'A')) {
+        __builtin_trap();
+    }
+}
+
+/** parses the input as a raw transaction. on success, the screens must be within tx_desc and
+ * every line must end in a null. */
+static void fuzz_display_tx_desc(const uint8_t *data, size_t size) {
+    if (size > sizeof(raw_tx)) {
+        return;
+    }
+    memmove(raw_tx, data, size);
+    raw_tx_len = size;
+    POISON_RAW_TX(size);
+
+    if (display_tx_desc() == SW_OK) {
+        if ((max_scr_ix > MAX_TX_TEXT_SCREENS) || (raw_tx_ix > raw_tx_len)) {
+            __builtin_trap();
+        }
+        for (unsigned int scr_ix = 0; scr_ix < max_scr_ix; scr_ix++) {
+            for (unsigned int line = 0; line < MAX_TX_TEXT_LINES; line++) {
+                if (memchr(tx_desc[scr_ix][line], '\0', MAX_TX_TEXT_WIDTH) == NULL) {
+                    __builtin_trap();
+                }
+            }
+        }
+    }
+    UNPOISON_RAW_TX();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_reset();
+    fuzz_display_tx_desc(data, size);
+    fuzz_to_base10_100m(data, size);
+    fuzz_to_address(data, size);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** runs the fuzz target once on each file given, or on each file of each directory given, for
+ * compilers without libFuzzer and to replay a corpus or a crash. */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/** the largest input read, larger than raw_tx so that the target sees too long inputs. */
+#define MAX_INPUT_LEN (1 << 16)
+
+/** runs the target on the file at path, returns the number of files run. */
+static unsigned int replay_file(const char *path) {
+    static uint8_t input[MAX_INPUT_LEN];
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    size_t size = fread(input, 1, sizeof(input), file);
+    fclose(file);
+    LLVMFuzzerTestOneInput(input, size);
+    return 1;
+}
+
+/** runs the target on path, a file or a directory of files. */
+static unsigned int replay(const char *path) {
+    struct stat path_stat;
+    if (stat(path, &path_stat) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    if (!S_ISDIR(path_stat.st_mode)) {
+        return replay_file(path);
+    }
+
+    unsigned int count = 0;
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char entry_path[4096];
+        snprintf(entry_path, sizeof(entry_path), "%s/%s", path, entry->d_name);
+        count += replay(entry_path);
+    }
+    closedir(dir);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file or directory>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    unsigned int count = 0;
+    for (int arg_ix = 1; arg_ix < argc; arg_ix++) {
+        count += replay(argv[arg_ix]);
+    }
+    printf("%u inputs run\n", count);
+    return EXIT_SUCCESS;
+}
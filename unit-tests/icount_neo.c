@@ -0,0 +1,341 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** counts the instructions of neo.c each benchmark case executes, by single stepping a child
+ * process and counting the steps within the code of neo.c, which is loaded on its own as a shared
+ * library. the hashes of the shim and the C library are left out, they are SDK calls on a device.
+ * the counts only change with the code of neo.c and the compiler, so they are compared with a
+ * baseline.
+ *
+ * usage: icount_neo <baseline> [tolerance in percent] to check the counts, or
+ *        icount_neo --write <baseline> to write them. */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <link.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "neo.h"
+#include "tx_vectors.h"
+
+/** the tolerance of the check, in percent of the baseline. */
+#define DEFAULT_TOLERANCE 3.0
+
+/** the line of the baseline with the version of the compiler that counted it. */
+#define BASELINE_COMPILER "# compiler "
+
+/** the length of the name of a case, in the baseline. */
+#define MAX_CASE_NAME_LEN 32
+
+/** the part of the public key request the app computes: the script hash and address of a key. */
+static void case_address(void) {
+    unsigned char public_key[65];
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    char address[ADDRESS_BASE58_LEN + 1];
+    public_key[0] = 0x04;
+    for (unsigned int ix = 1; ix < sizeof(public_key); ix++) {
+        public_key[ix] = ix;
+    }
+    public_key_to_script_hash(public_key, script_hash);
+    memset(address, '\0', sizeof(address));
+    to_address(address, sizeof(address), script_hash);
+}
+
+/** the review of a contract transaction of one input and output_count outputs, as
+ * test/tx_generator.py builds it: alternately 1 NEO and 0.001 GAS to the same address. */
+static void sign_outputs(unsigned int output_count) {
+    static const char NEO_ASSET_ID_LE[] =
+        "9b7cffdaa674beae0f930ebe6085af9093e5fe56b34a5c220ccdcf6efc336fc5";
+    static const char GAS_ASSET_ID_LE[] =
+        "e72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60";
+    unsigned int len = 0;
+
+    raw_tx[len++] = TX_CONTRACT;
+    raw_tx[len++] = 0x00;  // version
+    raw_tx[len++] = 0x00;  // attributes
+    raw_tx[len++] = 0x01;  // inputs
+    memset(raw_tx + len, 0x11, COIN_REFERENCES_LEN);
+    len += COIN_REFERENCES_LEN;
+    raw_tx[len++] = output_count;
+    for (unsigned int ix = 0; ix < output_count; ix++) {
+        len += from_hex((ix % 2 == 0) ? NEO_ASSET_ID_LE : GAS_ASSET_ID_LE, raw_tx + len, 32);
+        uint64_to_value(raw_tx + len, (ix % 2 == 0) ? 100000000 : 100000);
+        len += VALUE_LEN;
+        len += from_hex(SCRIPT_HASH_AHXSMB, raw_tx + len, SCRIPT_HASH_LEN);
+    }
+    raw_tx_len = len;
+    raw_tx_ix = 0;
+    if (display_tx_desc() != SW_OK) {
+        fprintf(stderr, "a transaction of %u outputs does not parse\n", output_count);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void case_sign_outputs_1(void) {
+    sign_outputs(1);
+}
+
+static void case_sign_outputs_8(void) {
+    sign_outputs(8);
+}
+
+/** the most outputs that fit in raw_tx. */
+static void case_sign_outputs_16(void) {
+    sign_outputs(16);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} icount_case_t;
+
+static const icount_case_t CASES[] = {
+    {"address", case_address},
+    {"sign_outputs_1", case_sign_outputs_1},
+    {"sign_outputs_8", case_sign_outputs_8},
+    {"sign_outputs_16", case_sign_outputs_16},
+};
+
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+/** the code of neo.c. */
+static uintptr_t code_start;
+static uintptr_t code_end;
+
+static int find_code(struct dl_phdr_info *info, size_t size, void *data) {
+    UNUSED(size);
+    UNUSED(data);
+    if (strstr(info->dlpi_name, "libneo_code") == NULL) {
+        return 0;
+    }
+    for (unsigned int ix = 0; ix < info->dlpi_phnum; ix++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[ix];
+        if ((phdr->p_type == PT_LOAD) && (phdr->p_flags & PF_X)) {
+            code_start = info->dlpi_addr + phdr->p_vaddr;
+            code_end = code_start + phdr->p_memsz;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** runs the cases in the child, each one between two stops. */
+static void run_child(void) {
+    if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0) {
+        perror("PTRACE_TRACEME");
+        _exit(EXIT_FAILURE);
+    }
+    raise(SIGSTOP);
+    for (unsigned int ix = 0; ix < CASE_COUNT; ix++) {
+        CASES[ix].run();
+        raise(SIGSTOP);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/** true if addr is in the code of neo.c. */
+static bool in_code(uintptr_t addr) {
+    return (addr >= code_start) && (addr < code_end);
+}
+
+/** waits for the child to stop, returns the signal it stopped with. */
+static int wait_stop(pid_t child) {
+    int status;
+    if ((waitpid(child, &status, 0) != child) || !WIFSTOPPED(status)) {
+        fprintf(stderr, "the child ended before its stop\n");
+        exit(EXIT_FAILURE);
+    }
+    return WSTOPSIG(status);
+}
+
+static void get_regs(pid_t child, struct user_regs_struct *regs) {
+    if (ptrace(PTRACE_GETREGS, child, NULL, regs) != 0) {
+        perror("PTRACE_GETREGS");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/** runs the child at full speed until it returns to addr, with a breakpoint there. */
+static void run_to(pid_t child, uintptr_t addr) {
+    errno = 0;
+    long word = ptrace(PTRACE_PEEKTEXT, child, (void *) addr, NULL);
+    if (errno != 0) {
+        perror("PTRACE_PEEKTEXT");
+        exit(EXIT_FAILURE);
+    }
+    long breakpoint = (word & ~0xFFL) | 0xCC;  // int3
+    if ((ptrace(PTRACE_POKETEXT, child, (void *) addr, (void *) breakpoint) != 0) ||
+        (ptrace(PTRACE_CONT, child, NULL, NULL) != 0) || (wait_stop(child) != SIGTRAP)) {
+        fprintf(stderr, "the child did not return to 0x%lx\n", (unsigned long) addr);
+        exit(EXIT_FAILURE);
+    }
+    struct user_regs_struct regs;
+    get_regs(child, &regs);
+    regs.rip = addr;
+    if ((ptrace(PTRACE_POKETEXT, child, (void *) addr, (void *) word) != 0) ||
+        (ptrace(PTRACE_SETREGS, child, NULL, &regs) != 0)) {
+        perror("PTRACE_POKETEXT");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/** single steps the child to its next stop, and returns the steps within the code of neo.c. when
+ * neo.c calls out, the child runs at full speed until the call returns. */
+static uint64_t count_to_stop(pid_t child) {
+    uint64_t count = 0;
+    bool prev_in_code = false;
+    unsigned long long prev_rsp = 0;
+    for (;;) {
+        if (ptrace(PTRACE_SINGLESTEP, child, NULL, NULL) != 0) {
+            perror("PTRACE_SINGLESTEP");
+            exit(EXIT_FAILURE);
+        }
+        if (wait_stop(child) == SIGSTOP) {
+            return count;
+        }
+        struct user_regs_struct regs;
+        get_regs(child, &regs);
+        if (in_code(regs.rip)) {
+            count++;
+            prev_in_code = true;
+            prev_rsp = regs.rsp;
+            continue;
+        }
+        // a call or a jump out of neo.c, not a return, has the return address on the stack.
+        if (prev_in_code && (regs.rsp <= prev_rsp)) {
+            errno = 0;
+            uintptr_t return_addr = ptrace(PTRACE_PEEKDATA, child, (void *) regs.rsp, NULL);
+            if ((errno == 0) && in_code(return_addr)) {
+                run_to(child, return_addr);
+                count++;
+                prev_rsp = regs.rsp + sizeof(return_addr);
+                continue;
+            }
+        }
+        prev_in_code = false;
+    }
+}
+
+/** counts the instructions of each case into counts. */
+static void count_cases(uint64_t *counts) {
+    if (dl_iterate_phdr(find_code, NULL) == 0) {
+        fprintf(stderr, "libneo_code is not loaded\n");
+        exit(EXIT_FAILURE);
+    }
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (child == 0) {
+        run_child();
+    }
+
+    int status;
+    if ((waitpid(child, &status, 0) != child) || !WIFSTOPPED(status)) {
+        fprintf(stderr, "the child can not be traced\n");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned int ix = 0; ix < CASE_COUNT; ix++) {
+        counts[ix] = count_to_stop(child);
+    }
+    ptrace(PTRACE_CONT, child, NULL, NULL);
+    waitpid(child, &status, 0);
+}
+
+/** writes the counts to the baseline at path, one "<case> <count>" line per case. */
+static int write_baseline(const char *path, const uint64_t *counts) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    fprintf(file, "# instructions of neo.c per case, counted by icount_neo.\n");
+    fprintf(file, "%s%s\n", BASELINE_COMPILER, __VERSION__);
+    for (unsigned int ix = 0; ix < CASE_COUNT; ix++) {
+        fprintf(file, "%s %llu\n", CASES[ix].name, (unsigned long long) counts[ix]);
+    }
+    fclose(file);
+    printf("%s written\n", path);
+    return EXIT_SUCCESS;
+}
+
+/** compares the counts with the baseline at path, fails if a case is missing from it or is off by
+ * more than tolerance percent. */
+static int check_baseline(const char *path, const uint64_t *counts, double tolerance) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    uint64_t baseline[CASE_COUNT];
+    bool found[CASE_COUNT] = {false};
+    char line[128];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[MAX_CASE_NAME_LEN + 1];
+        unsigned long long count;
+        if (strncmp(line, BASELINE_COMPILER, strlen(BASELINE_COMPILER)) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            if (strcmp(line + strlen(BASELINE_COMPILER), __VERSION__) != 0) {
+                printf("the baseline was counted with compiler %s, this build is from %s\n",
+                       line + strlen(BASELINE_COMPILER),
+                       __VERSION__);
+            }
+            continue;
+        }
+        if ((line[0] == '#') || (sscanf(line, "%32s %llu", name, &count) != 2)) {
+            continue;
+        }
+        for (unsigned int ix = 0; ix < CASE_COUNT; ix++) {
+            if (strcmp(name, CASES[ix].name) == 0) {
+                baseline[ix] = count;
+                found[ix] = true;
+            }
+        }
+    }
+    fclose(file);
+
+    int result = EXIT_SUCCESS;
+    for (unsigned int ix = 0; ix < CASE_COUNT; ix++) {
+        if (!found[ix]) {
+            printf("%-16s %10llu  not in the baseline\n",
+                   CASES[ix].name,
+                   (unsigned long long) counts[ix]);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        double change = 100.0 * ((double) counts[ix] - (double) baseline[ix]) / baseline[ix];
+        bool within = (change <= tolerance) && (change >= -tolerance);
+        printf("%-16s %10llu  baseline %10llu  %+6.2f%%%s\n",
+               CASES[ix].name,
+               (unsigned long long) counts[ix],
+               (unsigned long long) baseline[ix],
+               change,
+               within ? "" : "  over the tolerance");
+        if (!within) {
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    uint64_t counts[CASE_COUNT];
+    if ((argc == 3) && (strcmp(argv[1], "--write") == 0)) {
+        count_cases(counts);
+        return write_baseline(argv[2], counts);
+    }
+    if ((argc == 2) || (argc == 3)) {
+        double tolerance = (argc == 3) ? strtod(argv[2], NULL) : DEFAULT_TOLERANCE;
+        count_cases(counts);
+        return check_baseline(argv[1], counts, tolerance);
+    }
+    fprintf(stderr, "usage: %s <baseline> [tolerance in percent]\n", argv[0]);
+    fprintf(stderr, "       %s --write <baseline>\n", argv[0]);
+    return EXIT_FAILURE;
+}
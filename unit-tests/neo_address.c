@@ -0,0 +1,337 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** the addresses of keys NEO_ADDRESS_LANES at a time. every message hashed on the way fits in one
+ * block, so the blocks of the lanes are hashed together, a word of each lane per vector element.
+ * the hashes are built for AVX2 and for the baseline of the host, SSE2 on x86-64, and picked when
+ * the library loads. base58 divides by 58^5 on 32 bit limbs, five digits per pass, instead of one
+ * digit per pass over the bytes. */
+
+#include <stdint.h>
+#include <string.h>
+#include "neo_address.h"
+
+/** the length of a SHA-256 hash, and of a block of both hashes. */
+#define SHA256_LEN 32
+#define BLOCK_LEN 64
+
+/** the verification script of a key: push 33 bytes, the compressed key, CHECKSIG. */
+#define VERIFICATION_SCRIPT_LEN 35
+
+/** the version byte of an address. */
+#define ADDRESS_VERSION 23
+
+/** the version, the script hash and the checksum, before base58. */
+#define ADDRESS_BYTES_LEN (1 + NEO_SCRIPT_HASH_LEN + 4)
+
+/** a word of each lane. */
+typedef uint32_t lanes_t __attribute__((vector_size(4 * NEO_ADDRESS_LANES)));
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t SHA256_H0[8] = {0x6a09e667,
+                                      0xbb67ae85,
+                                      0x3c6ef372,
+                                      0xa54ff53a,
+                                      0x510e527f,
+                                      0x9b05688c,
+                                      0x1f83d9ab,
+                                      0x5be0cd19};
+
+static const char BASE_58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static const uint32_t RIPEMD160_H0[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+/** the constants of the left and right lines, per round of 16 steps. */
+static const uint32_t RIPEMD160_K[5] = {0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e};
+static const uint32_t RIPEMD160_K_RIGHT[5] = {0x50a28be6,
+                                              0x5c4dd124,
+                                              0x6d703ef3,
+                                              0x7a6d76e9,
+                                              0x00000000};
+
+/** the message word and the rotation of each step of the left and right lines. */
+static const unsigned char RIPEMD160_R[80] = {
+    0, 1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 7,  4,  13, 1,
+    10, 6, 15, 3,  12, 0,  9,  5,  2,  14, 11, 8,  3,  10, 14, 4,  9,  15, 8,  1,
+    2,  7, 0,  6,  13, 11, 5,  12, 1,  9,  11, 10, 0,  8,  12, 4,  13, 3,  7,  15,
+    14, 5, 6,  2,  4,  0,  5,  9,  7,  12, 2,  10, 14, 1,  3,  8,  11, 6,  15, 13};
+static const unsigned char RIPEMD160_R_RIGHT[80] = {
+    5,  14, 7,  0, 9, 2,  11, 4,  13, 6,  15, 8,  1,  10, 3,  12, 6,  11, 3,  7,
+    0,  13, 5,  10, 14, 15, 8,  12, 4,  9,  1,  2,  15, 5,  1,  3,  7,  14, 6,  9,
+    11, 8,  12, 2,  10, 0,  4,  13, 8,  6,  4,  1,  3,  11, 15, 0,  5,  12, 2,  13,
+    9,  7,  10, 14, 12, 15, 10, 4,  1,  5,  8,  7,  6,  2,  13, 14, 0,  3,  9,  11};
+static const unsigned char RIPEMD160_S[80] = {
+    11, 14, 15, 12, 5,  8,  7,  9,  11, 13, 14, 15, 6,  7,  9,  8,  7,  6,  8,  13,
+    11, 9,  7,  15, 7,  12, 15, 9,  11, 7,  13, 12, 11, 13, 6,  7,  14, 9,  13, 15,
+    14, 8,  13, 6,  5,  12, 7,  5,  11, 12, 14, 15, 14, 15, 9,  8,  9,  14, 5,  6,
+    8,  6,  5,  12, 9,  15, 5,  11, 6,  8,  13, 12, 5,  12, 13, 14, 11, 8,  5,  6};
+static const unsigned char RIPEMD160_S_RIGHT[80] = {
+    8,  9,  9,  11, 13, 15, 15, 5,  7,  7,  8,  11, 14, 14, 12, 6,  9,  13, 15, 7,
+    12, 8,  9,  11, 7,  7,  12, 7,  6,  15, 13, 11, 9,  7,  15, 11, 8,  6,  6,  14,
+    12, 13, 5,  14, 13, 13, 7,  5,  15, 5,  8,  11, 14, 14, 6,  14, 6,  9,  12, 9,
+    12, 5,  15, 8,  8,  5,  12, 9,  12, 5,  14, 6,  8,  13, 6,  5,  15, 13, 11, 11};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define HASH_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define HASH_CLONES
+#endif
+
+/** hashes the one block message of each lane, each len bytes at stride bytes from the last, and
+ * writes the hashes to out, SHA256_LEN bytes apart. len is at most 55, so the padding fits. */
+HASH_CLONES static void sha256_x8(const unsigned char *in,
+                                    size_t stride,
+                                    size_t len,
+                                    unsigned char *out) {
+    unsigned char blocks[NEO_ADDRESS_LANES][BLOCK_LEN];
+    lanes_t w[64];
+    for (unsigned int lane = 0; lane < NEO_ADDRESS_LANES; lane++) {
+        memset(blocks[lane], 0, BLOCK_LEN);
+        memmove(blocks[lane], in + (lane * stride), len);
+        blocks[lane][len] = 0x80;
+        blocks[lane][BLOCK_LEN - 2] = (len * 8) >> 8;
+        blocks[lane][BLOCK_LEN - 1] = (len * 8) & 0xFF;
+    }
+    for (unsigned int ix = 0; ix < 16; ix++) {
+        for (unsigned int lane = 0; lane < NEO_ADDRESS_LANES; lane++) {
+            const unsigned char *word = blocks[lane] + (4 * ix);
+            w[ix][lane] = ((uint32_t) word[0] << 24) | ((uint32_t) word[1] << 16) |
+                          ((uint32_t) word[2] << 8) | word[3];
+        }
+    }
+    for (unsigned int ix = 16; ix < 64; ix++) {
+        lanes_t s0 = ROTR(w[ix - 15], 7) ^ ROTR(w[ix - 15], 18) ^ (w[ix - 15] >> 3);
+        lanes_t s1 = ROTR(w[ix - 2], 17) ^ ROTR(w[ix - 2], 19) ^ (w[ix - 2] >> 10);
+        w[ix] = w[ix - 16] + s0 + w[ix - 7] + s1;
+    }
+
+    lanes_t a = SHA256_H0[0] + (lanes_t){0}, b = SHA256_H0[1] + (lanes_t){0};
+    lanes_t c = SHA256_H0[2] + (lanes_t){0}, d = SHA256_H0[3] + (lanes_t){0};
+    lanes_t e = SHA256_H0[4] + (lanes_t){0}, f = SHA256_H0[5] + (lanes_t){0};
+    lanes_t g = SHA256_H0[6] + (lanes_t){0}, h = SHA256_H0[7] + (lanes_t){0};
+    for (unsigned int ix = 0; ix < 64; ix++) {
+        lanes_t s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+        lanes_t ch = (e & f) ^ (~e & g);
+        lanes_t t1 = h + s1 + ch + SHA256_K[ix] + w[ix];
+        lanes_t s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+        lanes_t maj = (a & b) ^ (a & c) ^ (b & c);
+        lanes_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    lanes_t state[8] = {a, b, c, d, e, f, g, h};
+
+    for (unsigned int lane = 0; lane < NEO_ADDRESS_LANES; lane++) {
+        unsigned char *hash = out + (lane * SHA256_LEN);
+        for (unsigned int ix = 0; ix < 8; ix++) {
+            uint32_t word = state[ix][lane] + SHA256_H0[ix];
+            hash[(4 * ix) + 0] = word >> 24;
+            hash[(4 * ix) + 1] = word >> 16;
+            hash[(4 * ix) + 2] = word >> 8;
+            hash[(4 * ix) + 3] = word;
+        }
+    }
+}
+
+/** the RIPEMD-160 function of a round, the left line takes them in order and the right one in the
+ * reverse order. a macro, as AVX vectors are not passed to functions the same way with and without
+ * AVX. */
+#define RIPEMD160_F(round, x, y, z)                                        \
+    (((round) == 0)   ? ((x) ^ (y) ^ (z))                                  \
+     : ((round) == 1) ? (((x) & (y)) | (~(x) & (z)))                       \
+     : ((round) == 2) ? (((x) | ~(y)) ^ (z))                               \
+     : ((round) == 3) ? (((x) & (z)) | ((y) & ~(z)))                       \
+                      : ((x) ^ ((y) | ~(z))))
+
+/** hashes the SHA256_LEN bytes of each lane, SHA256_LEN bytes apart, and writes the hashes to out,
+ * NEO_SCRIPT_HASH_LEN bytes apart. */
+HASH_CLONES static void ripemd160_x8(const unsigned char *in, unsigned char *out) {
+    lanes_t x[16];
+    for (unsigned int ix = 0; ix < 16; ix++) {
+        x[ix] = (lanes_t){0};
+    }
+    for (unsigned int lane = 0; lane < NEO_ADDRESS_LANES; lane++) {
+        const unsigned char *message = in + (lane * SHA256_LEN);
+        for (unsigned int ix = 0; ix < SHA256_LEN / 4; ix++) {
+            const unsigned char *word = message + (4 * ix);
+            x[ix][lane] = ((uint32_t) word[3] << 24) | ((uint32_t) word[2] << 16) |
+                          ((uint32_t) word[1] << 8) | word[0];
+        }
+        // the padding and the length in bits, little endian.
+        x[SHA256_LEN / 4][lane] = 0x80;
+        x[14][lane] = SHA256_LEN * 8;
+    }
+
+    lanes_t a = RIPEMD160_H0[0] + (lanes_t){0}, b = RIPEMD160_H0[1] + (lanes_t){0};
+    lanes_t c = RIPEMD160_H0[2] + (lanes_t){0}, d = RIPEMD160_H0[3] + (lanes_t){0};
+    lanes_t e = RIPEMD160_H0[4] + (lanes_t){0};
+    lanes_t a_right = a, b_right = b, c_right = c, d_right = d, e_right = e;
+    for (unsigned int ix = 0; ix < 80; ix++) {
+        unsigned int round = ix / 16;
+        lanes_t t = a + RIPEMD160_F(round, b, c, d) + x[RIPEMD160_R[ix]] + RIPEMD160_K[round];
+        t = ROTL(t, RIPEMD160_S[ix]) + e;
+        a = e;
+        e = d;
+        d = ROTL(c, 10);
+        c = b;
+        b = t;
+
+        t = a_right + RIPEMD160_F(4 - round, b_right, c_right, d_right) +
+            x[RIPEMD160_R_RIGHT[ix]] + RIPEMD160_K_RIGHT[round];
+        t = ROTL(t, RIPEMD160_S_RIGHT[ix]) + e_right;
+        a_right = e_right;
+        e_right = d_right;
+        d_right = ROTL(c_right, 10);
+        c_right = b_right;
+        b_right = t;
+    }
+    lanes_t state[5] = {RIPEMD160_H0[1] + c + d_right,
+                        RIPEMD160_H0[2] + d + e_right,
+                        RIPEMD160_H0[3] + e + a_right,
+                        RIPEMD160_H0[4] + a + b_right,
+                        RIPEMD160_H0[0] + b + c_right};
+
+    for (unsigned int lane = 0; lane < NEO_ADDRESS_LANES; lane++) {
+        unsigned char *hash = out + (lane * NEO_SCRIPT_HASH_LEN);
+        for (unsigned int ix = 0; ix < 5; ix++) {
+            uint32_t word = state[ix][lane];
+            hash[(4 * ix) + 0] = word;
+            hash[(4 * ix) + 1] = word >> 8;
+            hash[(4 * ix) + 2] = word >> 16;
+            hash[(4 * ix) + 3] = word >> 24;
+        }
+    }
+}
+
+/** encodes the ADDRESS_BYTES_LEN bytes of in in base58 to out, with a terminating null. */
+static void encode_address_base58(const unsigned char *in, char *out) {
+    // the number, big endian in 32 bit limbs, the first limb holding the bytes left over.
+    uint32_t limbs[(ADDRESS_BYTES_LEN + 3) / 4];
+    const unsigned int limb_count = sizeof(limbs) / sizeof(limbs[0]);
+    memset(limbs, 0, sizeof(limbs));
+    for (unsigned int ix = 0; ix < ADDRESS_BYTES_LEN; ix++) {
+        unsigned int byte_ix = (limb_count * 4) - ADDRESS_BYTES_LEN + ix;
+        limbs[byte_ix / 4] |= (uint32_t) in[ix] << (8 * (3 - (byte_ix % 4)));
+    }
+
+    // five digits per division by 58^5, least significant first.
+    char digits[NEO_ADDRESS_LEN + 5];
+    unsigned int digit_count = 0;
+    unsigned int first_limb = 0;
+    while (first_limb < limb_count) {
+        uint64_t remainder = 0;
+        for (unsigned int ix = first_limb; ix < limb_count; ix++) {
+            uint64_t part = (remainder << 32) | limbs[ix];
+            limbs[ix] = part / 656356768;  // 58^5
+            remainder = part % 656356768;
+        }
+        while ((first_limb < limb_count) && (limbs[first_limb] == 0)) {
+            first_limb++;
+        }
+        for (unsigned int ix = 0; ix < 5; ix++) {
+            digits[digit_count++] = remainder % 58;
+            remainder /= 58;
+        }
+    }
+    while ((digit_count > 0) && (digits[digit_count - 1] == 0)) {
+        digit_count--;
+    }
+
+    // a '1' for each leading zero byte, then the digits, most significant first.
+    unsigned int out_ix = 0;
+    for (unsigned int ix = 0; (ix < ADDRESS_BYTES_LEN) && (in[ix] == 0); ix++) {
+        out[out_ix++] = BASE_58_ALPHABET[0];
+    }
+    while (digit_count > 0) {
+        out[out_ix++] = BASE_58_ALPHABET[(unsigned char) digits[--digit_count]];
+    }
+    out[out_ix] = '\0';
+}
+
+/** the script hashes of the count, at most NEO_ADDRESS_LANES, keys. */
+static void script_hashes_x8(const unsigned char *public_keys,
+                             size_t count,
+                             unsigned char *script_hashes) {
+    unsigned char scripts[NEO_ADDRESS_LANES][VERIFICATION_SCRIPT_LEN];
+    unsigned char hashes[NEO_ADDRESS_LANES][SHA256_LEN];
+    memset(scripts, 0, sizeof(scripts));
+    for (size_t lane = 0; lane < count; lane++) {
+        const unsigned char *public_key = public_keys + (lane * NEO_PUBLIC_KEY_LEN);
+        scripts[lane][0] = 0x21;
+        scripts[lane][1] = (public_key[64] & 1) ? 0x03 : 0x02;
+        memmove(&scripts[lane][2], public_key + 1, 32);
+        scripts[lane][VERIFICATION_SCRIPT_LEN - 1] = 0xAC;
+    }
+    unsigned char lane_script_hashes[NEO_ADDRESS_LANES][NEO_SCRIPT_HASH_LEN];
+    sha256_x8(scripts[0], VERIFICATION_SCRIPT_LEN, VERIFICATION_SCRIPT_LEN, hashes[0]);
+    ripemd160_x8(hashes[0], lane_script_hashes[0]);
+    memmove(script_hashes, lane_script_hashes, count * NEO_SCRIPT_HASH_LEN);
+}
+
+/** the addresses of the count, at most NEO_ADDRESS_LANES, script hashes. */
+static void addresses_x8(const unsigned char *script_hashes, size_t count, char *addresses) {
+    unsigned char address_bytes[NEO_ADDRESS_LANES][ADDRESS_BYTES_LEN];
+    unsigned char hashes_0[NEO_ADDRESS_LANES][SHA256_LEN];
+    unsigned char hashes_1[NEO_ADDRESS_LANES][SHA256_LEN];
+    memset(address_bytes, 0, sizeof(address_bytes));
+    for (size_t lane = 0; lane < count; lane++) {
+        address_bytes[lane][0] = ADDRESS_VERSION;
+        memmove(&address_bytes[lane][1],
+                script_hashes + (lane * NEO_SCRIPT_HASH_LEN),
+                NEO_SCRIPT_HASH_LEN);
+    }
+    sha256_x8(address_bytes[0], ADDRESS_BYTES_LEN, 1 + NEO_SCRIPT_HASH_LEN, hashes_0[0]);
+    sha256_x8(hashes_0[0], SHA256_LEN, SHA256_LEN, hashes_1[0]);
+    for (size_t lane = 0; lane < count; lane++) {
+        memmove(&address_bytes[lane][1 + NEO_SCRIPT_HASH_LEN], hashes_1[lane], 4);
+        encode_address_base58(address_bytes[lane], addresses + (lane * (NEO_ADDRESS_LEN + 1)));
+    }
+}
+
+void neo_script_hashes(const unsigned char *public_keys,
+                       size_t count,
+                       unsigned char *script_hashes) {
+    for (size_t ix = 0; ix < count; ix += NEO_ADDRESS_LANES) {
+        size_t lanes = (count - ix < NEO_ADDRESS_LANES) ? count - ix : NEO_ADDRESS_LANES;
+        script_hashes_x8(public_keys + (ix * NEO_PUBLIC_KEY_LEN),
+                         lanes,
+                         script_hashes + (ix * NEO_SCRIPT_HASH_LEN));
+    }
+}
+
+void neo_script_hash_addresses(const unsigned char *script_hashes, size_t count, char *addresses) {
+    for (size_t ix = 0; ix < count; ix += NEO_ADDRESS_LANES) {
+        size_t lanes = (count - ix < NEO_ADDRESS_LANES) ? count - ix : NEO_ADDRESS_LANES;
+        addresses_x8(script_hashes + (ix * NEO_SCRIPT_HASH_LEN),
+                     lanes,
+                     addresses + (ix * (NEO_ADDRESS_LEN + 1)));
+    }
+}
+
+void neo_addresses(const unsigned char *public_keys, size_t count, char *addresses) {
+    unsigned char script_hashes[NEO_ADDRESS_LANES][NEO_SCRIPT_HASH_LEN];
+    for (size_t ix = 0; ix < count; ix += NEO_ADDRESS_LANES) {
+        size_t lanes = (count - ix < NEO_ADDRESS_LANES) ? count - ix : NEO_ADDRESS_LANES;
+        script_hashes_x8(public_keys + (ix * NEO_PUBLIC_KEY_LEN), lanes, script_hashes[0]);
+        addresses_x8(script_hashes[0], lanes, addresses + (ix * (NEO_ADDRESS_LEN + 1)));
+    }
+}
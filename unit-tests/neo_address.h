@@ -0,0 +1,35 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** addresses of many public keys at once, for host tools. the results are the ones of
+ * public_key_to_script_hash() and to_address() in src/neo.c, which test_neo_address checks. */
+#ifndef NEO_ADDRESS_H
+#define NEO_ADDRESS_H
+
+#include <stddef.h>
+
+/** the length of an uncompressed public key: 0x04, then x and y. */
+#define NEO_PUBLIC_KEY_LEN 65
+
+/** the length of a script hash. */
+#define NEO_SCRIPT_HASH_LEN 20
+
+/** the length of an address, without its terminating null. */
+#define NEO_ADDRESS_LEN 34
+
+/** the keys hashed at once, the lanes of the SHA-256 vectors. */
+#define NEO_ADDRESS_LANES 8
+
+/** writes the script hash of each of the count public keys to script_hashes. */
+void neo_script_hashes(const unsigned char *public_keys, size_t count, unsigned char *script_hashes);
+
+/** writes the address of each of the count script hashes to addresses, NEO_ADDRESS_LEN characters
+ * and a null each. */
+void neo_script_hash_addresses(const unsigned char *script_hashes, size_t count, char *addresses);
+
+/** writes the address of each of the count public keys to addresses, NEO_ADDRESS_LEN characters
+ * and a null each. */
+void neo_addresses(const unsigned char *public_keys, size_t count, char *addresses);
+
+#endif  // NEO_ADDRESS_H
@@ -0,0 +1,363 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** decodes a file of raw transactions with the parser of neo.c, and writes the screens the device
+ * would show for each one as a JSON line, in the order of the file.
+ *
+ * usage: neo_decode [-b] [-j workers] [-c chunk length] [-o output] <input>
+ *   the input holds one transaction in hex per line, or with -b, transactions in binary, each after
+ *   its length in two bytes big endian. empty lines and lines starting with # are skipped.
+ *
+ * the parser keeps its state in globals, as on the device, so the transactions are decoded by
+ * worker processes, one per core by default. they take chunks of transactions as they go from a
+ * counter they share, so a slow chunk does not hold the others up. */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "neo.h"
+
+/** the transactions a worker takes at a time, by default. */
+#define DEFAULT_CHUNK_LEN 1024
+
+/** the status of a transaction that does not fit in raw_tx, as the app answers it. */
+#define SW_TX_TOO_LONG 0x6D08
+
+/** a transaction in the input: where it starts and its length, in hex characters or bytes. */
+typedef struct {
+    size_t offset;
+    unsigned int len;
+} record_t;
+
+/** where the output of a chunk is: the worker that decoded it and the part of its output file. */
+typedef struct {
+    unsigned int worker;
+    off_t offset;
+    size_t len;
+} chunk_out_t;
+
+/** the state the workers share. */
+typedef struct {
+    size_t next_chunk;
+    chunk_out_t chunks[];
+} shared_t;
+
+static const unsigned char *input;
+static size_t input_len;
+static bool binary_input;
+static record_t *records;
+static size_t record_count;
+static size_t chunk_len = DEFAULT_CHUNK_LEN;
+
+/** adds a record to records, growing it as needed. */
+static void add_record(size_t offset, unsigned int len) {
+    static size_t capacity;
+    if (record_count == capacity) {
+        capacity = (capacity == 0) ? DEFAULT_CHUNK_LEN : 2 * capacity;
+        records = realloc(records, capacity * sizeof(record_t));
+        if (records == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    records[record_count].offset = offset;
+    records[record_count].len = len;
+    record_count++;
+}
+
+/** finds the transactions of the input. */
+static void index_records(void) {
+    size_t offset = 0;
+    while (offset < input_len) {
+        if (binary_input) {
+            if (offset + 2 > input_len) {
+                fprintf(stderr, "the input ends in the length of a transaction\n");
+                exit(EXIT_FAILURE);
+            }
+            unsigned int len = (input[offset] << 8) | input[offset + 1];
+            if (offset + 2 + len > input_len) {
+                fprintf(stderr, "the input ends in a transaction\n");
+                exit(EXIT_FAILURE);
+            }
+            add_record(offset + 2, len);
+            offset += 2 + len;
+            continue;
+        }
+
+        const unsigned char *end = memchr(input + offset, '\n', input_len - offset);
+        size_t line_end = (end == NULL) ? input_len : (size_t) (end - input);
+        size_t len = line_end - offset;
+        while ((len > 0) && ((input[offset + len - 1] == '\r') || (input[offset + len - 1] == ' '))) {
+            len--;
+        }
+        if ((len > 0) && (input[offset] != '#')) {
+            add_record(offset, len);
+        }
+        offset = line_end + 1;
+    }
+}
+
+static int hex_digit(unsigned char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/** loads the transaction of record into raw_tx, as the last part of an upload leaves it. returns
+ * false if it is not hex. */
+static bool load_record(const record_t *record) {
+    const unsigned char *data = input + record->offset;
+    if (binary_input) {
+        memmove(raw_tx, data, record->len);
+        raw_tx_len = record->len;
+    } else {
+        if (record->len % 2 != 0) {
+            return false;
+        }
+        for (unsigned int ix = 0; ix < record->len / 2; ix++) {
+            int high = hex_digit(data[2 * ix]);
+            int low = hex_digit(data[(2 * ix) + 1]);
+            if ((high < 0) || (low < 0)) {
+                return false;
+            }
+            raw_tx[ix] = (high << 4) | low;
+        }
+        raw_tx_len = record->len / 2;
+    }
+    raw_tx_ix = 0;
+    return true;
+}
+
+/** writes text, of at most len characters, as a JSON string. */
+static void write_json_string(FILE *out, const char *text, size_t len) {
+    fputc('"', out);
+    for (size_t ix = 0; (ix < len) && (text[ix] != '\0'); ix++) {
+        unsigned char c = text[ix];
+        if ((c == '"') || (c == '\\')) {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if ((c < 0x20) || (c >= 0x7F)) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/** decodes the transaction at index ix and writes its JSON line. */
+static void decode_record(size_t ix, FILE *out) {
+    const record_t *record = &records[ix];
+    unsigned int tx_len = binary_input ? record->len : record->len / 2;
+    if (tx_len > MAX_TX_RAW_LENGTH) {
+        fprintf(out, "{\"index\":%zu,\"status\":\"%04X\"}\n", ix, SW_TX_TOO_LONG);
+        return;
+    }
+    memset(tx_desc, 0, sizeof(tx_desc));
+    max_scr_ix = 0;
+    if (!load_record(record)) {
+        fprintf(out, "{\"index\":%zu,\"error\":\"not hex\"}\n", ix);
+        return;
+    }
+
+    unsigned short sw = display_tx_desc();
+    if (sw != SW_OK) {
+        fprintf(out, "{\"index\":%zu,\"status\":\"%04X\",\"offset\":%u}\n", ix, sw, raw_tx_ix);
+        return;
+    }
+    fprintf(out, "{\"index\":%zu,\"status\":\"%04X\",\"screens\":[", ix, sw);
+    for (unsigned int scr_ix = 0; scr_ix < max_scr_ix; scr_ix++) {
+        fputs((scr_ix == 0) ? "[" : ",[", out);
+        for (unsigned int line = 0; line < MAX_TX_TEXT_LINES; line++) {
+            if (line != 0) {
+                fputc(',', out);
+            }
+            write_json_string(out, tx_desc[scr_ix][line], MAX_TX_TEXT_WIDTH);
+        }
+        fputc(']', out);
+    }
+    fputs("]}\n", out);
+}
+
+/** takes chunks from the shared counter until there are none left, and writes their lines to out.
+ */
+static void run_worker(unsigned int worker, shared_t *shared, size_t chunk_count, FILE *out) {
+    for (;;) {
+        size_t chunk = __atomic_fetch_add(&shared->next_chunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= chunk_count) {
+            break;
+        }
+        off_t start = ftello(out);
+        size_t end_ix = (chunk + 1) * chunk_len;
+        if (end_ix > record_count) {
+            end_ix = record_count;
+        }
+        for (size_t ix = chunk * chunk_len; ix < end_ix; ix++) {
+            decode_record(ix, out);
+        }
+        shared->chunks[chunk].worker = worker;
+        shared->chunks[chunk].offset = start;
+        shared->chunks[chunk].len = ftello(out) - start;
+    }
+    if (fflush(out) != 0) {
+        perror("fflush");
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/** copies len bytes at offset of the file in to out. */
+static void copy_out(int in, off_t offset, size_t len, FILE *out) {
+    static char buffer[1 << 16];
+    while (len > 0) {
+        size_t part = (len < sizeof(buffer)) ? len : sizeof(buffer);
+        ssize_t read_len = pread(in, buffer, part, offset);
+        if (read_len <= 0) {
+            perror("pread");
+            exit(EXIT_FAILURE);
+        }
+        fwrite(buffer, 1, read_len, out);
+        offset += read_len;
+        len -= read_len;
+    }
+}
+
+/** decodes the records with the workers, and writes their lines to out in the order of the input.
+ */
+static void decode_records(unsigned int worker_count, FILE *out) {
+    size_t chunk_count = (record_count + chunk_len - 1) / chunk_len;
+    if (worker_count > chunk_count) {
+        worker_count = (chunk_count == 0) ? 1 : chunk_count;
+    }
+    size_t shared_len = sizeof(shared_t) + (chunk_count * sizeof(chunk_out_t));
+    shared_t *shared =
+        mmap(NULL, shared_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    FILE **worker_out = calloc(worker_count, sizeof(FILE *));
+    pid_t *workers = calloc(worker_count, sizeof(pid_t));
+    if ((shared == MAP_FAILED) || (worker_out == NULL) || (workers == NULL)) {
+        perror("decode_records");
+        exit(EXIT_FAILURE);
+    }
+    fflush(out);
+
+    for (unsigned int worker = 0; worker < worker_count; worker++) {
+        worker_out[worker] = tmpfile();
+        if (worker_out[worker] == NULL) {
+            perror("tmpfile");
+            exit(EXIT_FAILURE);
+        }
+        workers[worker] = fork();
+        if (workers[worker] < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (workers[worker] == 0) {
+            run_worker(worker, shared, chunk_count, worker_out[worker]);
+        }
+    }
+
+    bool failed = false;
+    for (unsigned int worker = 0; worker < worker_count; worker++) {
+        int status;
+        if ((waitpid(workers[worker], &status, 0) != workers[worker]) || !WIFEXITED(status) ||
+            (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+            fprintf(stderr, "worker %u failed\n", worker);
+            failed = true;
+        }
+    }
+    if (failed) {
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        const chunk_out_t *chunk_out = &shared->chunks[chunk];
+        copy_out(fileno(worker_out[chunk_out->worker]), chunk_out->offset, chunk_out->len, out);
+    }
+    for (unsigned int worker = 0; worker < worker_count; worker++) {
+        fclose(worker_out[worker]);
+    }
+    free(worker_out);
+    free(workers);
+    munmap(shared, shared_len);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-b] [-j workers] [-c chunk length] [-o output] <input>\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    long worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *output_path = NULL;
+    int opt;
+    long chunk_len_arg = DEFAULT_CHUNK_LEN;
+    while ((opt = getopt(argc, argv, "bj:c:o:")) != -1) {
+        switch (opt) {
+            case 'b':
+                binary_input = true;
+                break;
+            case 'j':
+                worker_count = strtol(optarg, NULL, 10);
+                break;
+            case 'c':
+                chunk_len_arg = strtol(optarg, NULL, 10);
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if ((optind != argc - 1) || (worker_count < 1) || (chunk_len_arg < 1)) {
+        usage(argv[0]);
+    }
+    chunk_len = chunk_len_arg;
+
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat input_stat;
+    if ((fd < 0) || (fstat(fd, &input_stat) != 0)) {
+        perror(argv[optind]);
+        return EXIT_FAILURE;
+    }
+    input_len = input_stat.st_size;
+    if (input_len > 0) {
+        input = mmap(NULL, input_len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (input == MAP_FAILED) {
+            perror("mmap");
+            return EXIT_FAILURE;
+        }
+    }
+    close(fd);
+
+    FILE *out = stdout;
+    if (output_path != NULL) {
+        out = fopen(output_path, "w");
+        if (out == NULL) {
+            perror(output_path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    index_records();
+    decode_records(worker_count, out);
+    if (fclose(out) != 0) {
+        perror("fclose");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** renders the screens of the cases of a file as text, the strings neo.c writes for the device to
+ * show, and compares them with a golden file per case, or writes the golden files.
+ *
+ * usage: neo_screens [--write] <cases> <golden directory>
+ *   a case is a line of the file: <name> tx <transaction in hex>, or <name> address <public key in
+ *   hex>. empty lines and lines starting with # are skipped. the golden file of a case is
+ *   <golden directory>/<name>.txt.
+ *
+ * on bagl devices a transaction shows the lines of its tx_desc screens, on NBGL devices the
+ * tag/value pairs of review_pairs. an address shows the lines of address58. */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include "neo.h"
+
+/** the length of an uncompressed public key. */
+#define PUBLIC_KEY_LEN 65
+
+static int hex_digit(char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/** writes the bytes of hex to out, returns their number, or -1 if hex is not hex of at most out_len
+ * bytes. */
+static int from_hex(const char *hex, unsigned char *out, unsigned int out_len) {
+    size_t hex_len = strlen(hex);
+    if ((hex_len % 2 != 0) || (hex_len / 2 > out_len)) {
+        return -1;
+    }
+    for (size_t ix = 0; ix < hex_len / 2; ix++) {
+        int high = hex_digit(hex[2 * ix]);
+        int low = hex_digit(hex[(2 * ix) + 1]);
+        if ((high < 0) || (low < 0)) {
+            return -1;
+        }
+        out[ix] = (high << 4) | low;
+    }
+    return hex_len / 2;
+}
+
+/** writes text, of at most len characters, quoted, so that blank and padded lines show. */
+static void write_quoted(FILE *out, const char *text, size_t len) {
+    fputc('"', out);
+    for (size_t ix = 0; (ix < len) && (text[ix] != '\0'); ix++) {
+        unsigned char c = text[ix];
+        if ((c == '"') || (c == '\\')) {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if ((c < 0x20) || (c >= 0x7F)) {
+            fprintf(out, "\\x%02x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputs("\"\n", out);
+}
+
+/** renders the review of the transaction in hex. */
+static bool render_tx(const char *hex, FILE *out) {
+    int len = from_hex(hex, raw_tx, sizeof(raw_tx));
+    if (len < 0) {
+        return false;
+    }
+    raw_tx_len = len;
+    raw_tx_ix = 0;
+    memset(tx_desc, 0, sizeof(tx_desc));
+    memset(&tx_summary, 0, sizeof(tx_summary));
+    max_scr_ix = 0;
+
+    unsigned short sw = display_tx_desc();
+    fprintf(out, "status %04X\n", sw);
+    if (sw != SW_OK) {
+        fprintf(out, "offset %u\n", raw_tx_ix);
+        return true;
+    }
+#ifdef HAVE_BAGL
+    for (unsigned int scr_ix = 0; scr_ix < max_scr_ix; scr_ix++) {
+        fprintf(out, "screen %u\n", scr_ix + 1);
+        for (unsigned int line = 0; line < MAX_TX_TEXT_LINES; line++) {
+            write_quoted(out, tx_desc[scr_ix][line], MAX_TX_TEXT_WIDTH);
+        }
+    }
+#else  // HAVE_NBGL
+    review_pair_t pairs[REVIEW_PAIRS_MAX];
+    unsigned char pair_count = review_pairs(pairs);
+    for (unsigned char pair_ix = 0; pair_ix < pair_count; pair_ix++) {
+        fprintf(out, "%s: ", pairs[pair_ix].item);
+        write_quoted(out, pairs[pair_ix].value, MAX_TX_TEXT_WIDTH);
+    }
+#endif
+    return true;
+}
+
+/** renders the address screen of the public key in hex. */
+static bool render_address(const char *hex, FILE *out) {
+    unsigned char public_key[PUBLIC_KEY_LEN];
+    if (from_hex(hex, public_key, sizeof(public_key)) != PUBLIC_KEY_LEN) {
+        return false;
+    }
+    memset(address58, 0, sizeof(address58));
+
+    unsigned short sw = display_public_key(public_key);
+    fprintf(out, "status %04X\n", sw);
+    for (unsigned int line = 0; line < ADDRESS58_LINES; line++) {
+        write_quoted(out, address58[line], MAX_TX_TEXT_WIDTH);
+    }
+    return true;
+}
+
+/** reads the whole file at path, null terminated, or returns NULL. */
+static char *read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    char *text = NULL;
+    size_t capacity = 0;
+    *len = 0;
+    for (;;) {
+        if (*len + 4096 + 1 > capacity) {
+            capacity = (capacity == 0) ? 8192 : 2 * capacity;
+            text = realloc(text, capacity);
+            if (text == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        size_t read_len = fread(text + *len, 1, 4096, file);
+        *len += read_len;
+        if (read_len == 0) {
+            break;
+        }
+    }
+    fclose(file);
+    text[*len] = '\0';
+    return text;
+}
+
+/** prints the first line where the rendering of a case differs from its golden file. */
+static void print_difference(const char *name, const char *golden, const char *rendered) {
+    unsigned int line = 1;
+    while ((*golden != '\0') && (*golden == *rendered)) {
+        if (*golden == '\n') {
+            line++;
+        }
+        golden++;
+        rendered++;
+    }
+    while ((line > 1) && (golden[-1] != '\n')) {
+        golden--;
+        rendered--;
+    }
+    fprintf(stderr,
+            "%s: line %u is\n  %.*s\nnot\n  %.*s\n",
+            name,
+            line,
+            (int) strcspn(rendered, "\n"),
+            rendered,
+            (int) strcspn(golden, "\n"),
+            golden);
+}
+
+/** renders a case and checks it against its golden file, or writes it. returns false if it does
+ * not match, or can not be rendered. */
+static bool run_case(const char *name,
+                     const char *kind,
+                     const char *hex,
+                     const char *golden_dir,
+                     bool write) {
+    char *rendered = NULL;
+    size_t rendered_len = 0;
+    FILE *out = open_memstream(&rendered, &rendered_len);
+    if (out == NULL) {
+        perror("open_memstream");
+        exit(EXIT_FAILURE);
+    }
+    bool rendered_ok = false;
+    if (strcmp(kind, "tx") == 0) {
+        rendered_ok = render_tx(hex, out);
+    } else if (strcmp(kind, "address") == 0) {
+        rendered_ok = render_address(hex, out);
+    }
+    fclose(out);
+    if (!rendered_ok) {
+        fprintf(stderr, "%s: not a valid %s case\n", name, kind);
+        free(rendered);
+        return false;
+    }
+
+    char *golden_path = NULL;
+    if (asprintf(&golden_path, "%s/%s.txt", golden_dir, name) < 0) {
+        perror("asprintf");
+        exit(EXIT_FAILURE);
+    }
+    bool matches = true;
+    if (write) {
+        FILE *golden = fopen(golden_path, "w");
+        if ((golden == NULL) || (fwrite(rendered, 1, rendered_len, golden) != rendered_len) ||
+            (fclose(golden) != 0)) {
+            perror(golden_path);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        size_t golden_len;
+        char *golden = read_file(golden_path, &golden_len);
+        if (golden == NULL) {
+            fprintf(stderr, "%s: no golden file %s\n", name, golden_path);
+            matches = false;
+        } else if ((golden_len != rendered_len) || (memcmp(golden, rendered, golden_len) != 0)) {
+            print_difference(name, golden, rendered);
+            matches = false;
+        }
+        free(golden);
+    }
+    free(golden_path);
+    free(rendered);
+    return matches;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [--write] <cases> <golden directory>\n", name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    bool write = false;
+    int arg_ix = 1;
+    if ((argc > arg_ix) && (strcmp(argv[arg_ix], "--write") == 0)) {
+        write = true;
+        arg_ix++;
+    }
+    if (argc != arg_ix + 2) {
+        usage(argv[0]);
+    }
+    const char *cases_path = argv[arg_ix];
+    const char *golden_dir = argv[arg_ix + 1];
+
+    FILE *cases = fopen(cases_path, "r");
+    if (cases == NULL) {
+        perror(cases_path);
+        return EXIT_FAILURE;
+    }
+    char *line = NULL;
+    size_t line_capacity = 0;
+    unsigned int case_count = 0;
+    unsigned int failed_count = 0;
+    while (getline(&line, &line_capacity, cases) >= 0) {
+        char *name = strtok(line, " \t\r\n");
+        if ((name == NULL) || (name[0] == '#')) {
+            continue;
+        }
+        char *kind = strtok(NULL, " \t\r\n");
+        char *hex = strtok(NULL, " \t\r\n");
+        if ((kind == NULL) || (hex == NULL)) {
+            fprintf(stderr, "%s: the case has no kind or no hex\n", name);
+            failed_count++;
+            continue;
+        }
+        case_count++;
+        if (!run_case(name, kind, hex, golden_dir, write)) {
+            failed_count++;
+        }
+    }
+    free(line);
+    fclose(cases);
+
+    if (write) {
+        printf("wrote %u golden files to %s\n", case_count, golden_dir);
+    } else {
+        printf("%u cases, %u differ\n", case_count, failed_count);
+    }
+    return (failed_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
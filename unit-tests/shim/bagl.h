@@ -0,0 +1,9 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's bagl.h, the host builds draw nothing. */
+#ifndef SHIM_BAGL_H
+#define SHIM_BAGL_H
+
+#endif  // SHIM_BAGL_H
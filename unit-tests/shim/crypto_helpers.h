@@ -0,0 +1,19 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's crypto_helpers.h. the host builds hold no seed, a test that derives keys
+ * defines the derivation. */
+#ifndef SHIM_CRYPTO_HELPERS_H
+#define SHIM_CRYPTO_HELPERS_H
+
+#include "cx.h"
+
+cx_err_t bip32_derive_get_pubkey_256(cx_curve_t curve,
+                                     const uint32_t *path,
+                                     size_t path_len,
+                                     uint8_t raw_pubkey[static 65],
+                                     uint8_t *chain_code,
+                                     cx_md_t hashID);
+
+#endif  // SHIM_CRYPTO_HELPERS_H
@@ -0,0 +1,69 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+// the low level OpenSSL hashes keep their state in the caller's context, like the SDK's.
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include <openssl/ripemd.h>
+#include <openssl/sha.h>
+#include "cx.h"
+
+_Static_assert(sizeof(((cx_sha256_t *) 0)->state) >= sizeof(SHA256_CTX),
+               "cx_sha256_t can not hold the OpenSSL state");
+_Static_assert(sizeof(((cx_ripemd160_t *) 0)->state) >= sizeof(RIPEMD160_CTX),
+               "cx_ripemd160_t can not hold the OpenSSL state");
+
+int cx_sha256_init(cx_sha256_t *hash) {
+    hash->header.algo = CX_SHA256;
+    SHA256_Init((SHA256_CTX *) hash->state);
+    return CX_SHA256;
+}
+
+int cx_ripemd160_init(cx_ripemd160_t *hash) {
+    hash->header.algo = CX_RIPEMD160;
+    RIPEMD160_Init((RIPEMD160_CTX *) hash->state);
+    return CX_RIPEMD160;
+}
+
+cx_err_t cx_hash_no_throw(cx_hash_t *hash,
+                          uint32_t mode,
+                          const uint8_t *in,
+                          size_t len,
+                          uint8_t *out,
+                          size_t out_len) {
+    switch (hash->algo) {
+        case CX_SHA256: {
+            SHA256_CTX *ctx = (SHA256_CTX *) ((cx_sha256_t *) hash)->state;
+            SHA256_Update(ctx, in, len);
+            if ((mode & CX_LAST) != 0) {
+                if (out_len < CX_SHA256_SIZE) {
+                    return CX_INVALID_PARAMETER;
+                }
+                SHA256_Final(out, ctx);
+            }
+            return CX_OK;
+        }
+        case CX_RIPEMD160: {
+            RIPEMD160_CTX *ctx = (RIPEMD160_CTX *) ((cx_ripemd160_t *) hash)->state;
+            RIPEMD160_Update(ctx, in, len);
+            if ((mode & CX_LAST) != 0) {
+                if (out_len < CX_RIPEMD160_SIZE) {
+                    return CX_INVALID_PARAMETER;
+                }
+                RIPEMD160_Final(out, ctx);
+            }
+            return CX_OK;
+        }
+        default:
+            return CX_INVALID_PARAMETER;
+    }
+}
+
+size_t cx_hash_sha256(const uint8_t *in, size_t len, uint8_t *out, size_t out_len) {
+    if (out_len < CX_SHA256_SIZE) {
+        return 0;
+    }
+    SHA256(in, len, out);
+    return CX_SHA256_SIZE;
+}
@@ -0,0 +1,78 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's cx.h: the hashes the parser and the encoders use, backed by OpenSSL. */
+#ifndef SHIM_CX_H
+#define SHIM_CX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "os.h"
+
+typedef uint32_t cx_err_t;
+
+#define CX_OK 0x00000000
+#define CX_INVALID_PARAMETER 0xFFFFFF84
+
+/** hash flag of the last block, which writes the digest. */
+#define CX_LAST (1 << 0)
+
+#define CX_SHA256_SIZE 32
+#define CX_RIPEMD160_SIZE 20
+
+typedef enum { CX_NONE, CX_RIPEMD160, CX_SHA256, CX_SHA512 } cx_md_t;
+
+typedef enum { CX_CURVE_NONE, CX_CURVE_256R1 } cx_curve_t;
+
+/** the header of a hash context, which tells its algorithm. */
+typedef struct {
+    cx_md_t algo;
+} cx_hash_t;
+
+/** a SHA-256 context, the state is the OpenSSL one. */
+typedef struct {
+    cx_hash_t header;
+    uint64_t state[16];
+} cx_sha256_t;
+
+/** a RIPEMD-160 context, the state is the OpenSSL one. */
+typedef struct {
+    cx_hash_t header;
+    uint64_t state[16];
+} cx_ripemd160_t;
+
+typedef struct {
+    cx_curve_t curve;
+    size_t W_len;
+    uint8_t W[65];
+} cx_ecfp_public_key_t;
+
+typedef struct {
+    cx_curve_t curve;
+    size_t d_len;
+    uint8_t d[32];
+} cx_ecfp_private_key_t;
+
+int cx_sha256_init(cx_sha256_t *hash);
+
+int cx_ripemd160_init(cx_ripemd160_t *hash);
+
+cx_err_t cx_hash_no_throw(cx_hash_t *hash,
+                          uint32_t mode,
+                          const uint8_t *in,
+                          size_t len,
+                          uint8_t *out,
+                          size_t out_len);
+
+size_t cx_hash_sha256(const uint8_t *in, size_t len, uint8_t *out, size_t out_len);
+
+#define CX_ASSERT(call)            \
+    do {                           \
+        cx_err_t cx_err_ = (call); \
+        if (cx_err_ != CX_OK) {    \
+            THROW(cx_err_);        \
+        }                          \
+    } while (0)
+
+#endif  // SHIM_CX_H
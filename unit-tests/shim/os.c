@@ -0,0 +1,18 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+#include <stdlib.h>
+#include "os.h"
+
+try_context_t *G_try_context = NULL;
+
+unsigned char G_io_apdu_buffer[260];
+
+void os_longjmp(unsigned int exception) {
+    if (G_try_context == NULL) {
+        fprintf(stderr, "exception 0x%04X thrown outside of a TRY block\n", exception);
+        abort();
+    }
+    longjmp(G_try_context->jmp_buf, exception);
+}
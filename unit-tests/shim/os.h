@@ -0,0 +1,73 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's os.h: what the parser and the encoders use, for host builds. */
+#ifndef SHIM_OS_H
+#define SHIM_OS_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define UNUSED(x) (void) (x)
+#define PRINTF(...)
+
+#ifndef APPNAME
+#define APPNAME "NEO"
+#endif
+#ifndef APPVERSION
+#define APPVERSION "0.0.0"
+#endif
+
+/** an exception, as THROW raises it. */
+typedef unsigned short exception_t;
+
+/** a TRY block, the innermost one catches what is thrown. */
+typedef struct try_context_s {
+    jmp_buf jmp_buf;
+    struct try_context_s *previous;
+    exception_t ex;
+} try_context_t;
+
+/** the innermost TRY block, NULL outside of one. */
+extern try_context_t *G_try_context;
+
+/** jumps to the innermost TRY block with the exception, aborts outside of one. */
+void os_longjmp(unsigned int exception);
+
+#define THROW(x) os_longjmp(x)
+
+#define BEGIN_TRY                                                  \
+    {                                                              \
+        try_context_t __try_context;                               \
+        __try_context.previous = G_try_context;                    \
+        G_try_context = &__try_context;                            \
+        __try_context.ex = setjmp(__try_context.jmp_buf);          \
+        if (__try_context.ex != 0) {                               \
+            G_try_context = __try_context.previous;                \
+        }
+
+#define TRY if (__try_context.ex == 0)
+#define CATCH(x) else if (__try_context.ex == (x))
+#define CATCH_OTHER(e) else for (exception_t e = __try_context.ex; e != 0; e = 0)
+#define CATCH_ALL else
+#define FINALLY
+#define CLOSE_TRY G_try_context = __try_context.previous
+#define END_TRY                                                    \
+    if (G_try_context == &__try_context) {                         \
+        G_try_context = __try_context.previous;                    \
+    }                                                              \
+    }
+
+extern unsigned char G_io_apdu_buffer[260];
+
+void explicit_bzero(void *s, size_t len);
+
+/** returns to the app that called this one as a library. */
+void os_lib_end(void);
+
+#endif  // SHIM_OS_H
@@ -0,0 +1,17 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's os_io_seproxyhal.h, the host builds have no IO. a test that sends
+ * responses defines io_exchange. */
+#ifndef SHIM_OS_IO_SEPROXYHAL_H
+#define SHIM_OS_IO_SEPROXYHAL_H
+
+#include "os.h"
+
+#define CHANNEL_APDU 0
+#define IO_RETURN_AFTER_TX 0x20
+
+unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len);
+
+#endif  // SHIM_OS_IO_SEPROXYHAL_H
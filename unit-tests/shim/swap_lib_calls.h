@@ -0,0 +1,62 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's swap_lib_calls.h: the parameters of the Exchange app's calls, for the
+ * host build of swap.c. */
+#ifndef SHIM_SWAP_LIB_CALLS_H
+#define SHIM_SWAP_LIB_CALLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RUN_APPLICATION 1
+#define SIGN_TRANSACTION 2
+#define CHECK_ADDRESS 3
+#define GET_PRINTABLE_AMOUNT 4
+
+#define MAX_PRINTABLE_AMOUNT_SIZE 50
+
+typedef struct {
+    uint8_t *coin_configuration;
+    uint8_t coin_configuration_length;
+    uint8_t *address_parameters;
+    uint8_t address_parameters_length;
+    char *address_to_check;
+    char *extra_id_to_check;
+    int result;
+} check_address_parameters_t;
+
+typedef struct {
+    uint8_t *coin_configuration;
+    uint8_t coin_configuration_length;
+    uint8_t *amount;
+    uint8_t amount_length;
+    bool is_fee;
+    char printable_amount[MAX_PRINTABLE_AMOUNT_SIZE];
+} get_printable_amount_parameters_t;
+
+typedef struct {
+    uint8_t *coin_configuration;
+    uint8_t coin_configuration_length;
+    uint8_t *amount;
+    uint8_t amount_length;
+    uint8_t *fee_amount;
+    uint8_t fee_amount_length;
+    char *destination_address;
+    char *destination_address_extra_id;
+    uint8_t result;
+} create_transaction_parameters_t;
+
+typedef struct {
+    unsigned int id;
+    unsigned int command;
+    unsigned int unused;
+    union {
+        check_address_parameters_t *check_address;
+        create_transaction_parameters_t *create_transaction;
+        get_printable_amount_parameters_t *get_printable_amount;
+    };
+} libargs_t;
+
+#endif  // SHIM_SWAP_LIB_CALLS_H
@@ -0,0 +1,48 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** the globals of ui.c and the functions of the other modules the parser and swap.c call, for host
+ * builds. the host builds show nothing and hold no attestations. */
+
+#include "neo.h"
+#include "attest.h"
+
+unsigned char publicKeyNeedsRefresh = 0;
+
+unsigned int curr_scr_ix;
+
+unsigned int max_scr_ix;
+
+unsigned char raw_tx[MAX_TX_RAW_LENGTH];
+
+unsigned int raw_tx_ix;
+
+unsigned int raw_tx_len;
+
+session_t session;
+
+char tx_desc[MAX_TX_TEXT_SCREENS][MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
+
+#ifdef HAVE_BAGL
+char curr_tx_desc[MAX_TX_TEXT_LINES][MAX_TX_TEXT_WIDTH];
+#endif
+
+char address58[ADDRESS58_LINES][MAX_TX_TEXT_WIDTH];
+
+void session_end(void) {
+    session.state = SESSION_IDLE;
+}
+
+void start_tx_desc(unsigned int scr_count) {
+    curr_scr_ix = 0;
+    max_scr_ix = scr_count;
+#ifdef HAVE_BAGL
+    memmove(curr_tx_desc, tx_desc[curr_scr_ix], CURR_TX_DESC_LEN);
+#endif
+}
+
+const attested_input_t *attest_find_input(const unsigned char *coin_reference) {
+    UNUSED(coin_reference);
+    return NULL;
+}
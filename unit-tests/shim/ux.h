@@ -0,0 +1,15 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** host shim of the SDK's ux.h, the host builds draw nothing. */
+#ifndef SHIM_UX_H
+#define SHIM_UX_H
+
+#include "os.h"
+
+typedef struct {
+    unsigned int stack_count;
+} ux_state_t;
+
+#endif  // SHIM_UX_H
@@ -0,0 +1,177 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** unit tests of the parser and the encoders of neo.c, built for the host. */
+
+#include <stdlib.h>
+#include "neo.h"
+#include "tx_vectors.h"
+
+/** the number of checks that failed. */
+static unsigned int failures;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                    #cond);                                                   \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+#define CHECK_STR(actual, expected)                                                   \
+    do {                                                                              \
+        if (strcmp((actual), (expected)) != 0) {                                      \
+            fprintf(stderr, "%s:%d: '%s' is not '%s'\n", __FILE__, __LINE__, (actual), \
+                    (expected));                                                      \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+/** the lines of screen scr_ix of tx_desc, joined. the address fills three lines on bagl devices
+ * and one on NBGL devices. */
+static const char *screen_text(unsigned int scr_ix) {
+    static char text[MAX_TX_TEXT_LINES * MAX_TX_TEXT_WIDTH];
+    text[0] = '\0';
+    for (unsigned int line = 0; line < MAX_TX_TEXT_LINES; line++) {
+        strncat(text, tx_desc[scr_ix][line], MAX_TX_TEXT_WIDTH);
+    }
+    return text;
+}
+
+static void test_to_address(void) {
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    char address[ADDRESS_BASE58_LEN + 1];
+    from_hex(SCRIPT_HASH_AHXSMB, script_hash, sizeof(script_hash));
+
+    memset(address, '\0', sizeof(address));
+    CHECK(to_address(address, sizeof(address), script_hash) == SW_OK);
+    CHECK_STR(address, "AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT");
+}
+
+static void test_to_base10_100m(void) {
+    unsigned char value[VALUE_LEN];
+    char text[MAX_TX_TEXT_WIDTH + 2];
+
+    uint64_to_value(value, 100000000);
+    memset(text, '\0', sizeof(text));
+    CHECK(to_base10_100m(text, value, sizeof(text)) == SW_OK);
+    CHECK_STR(text, "00001.00000000");
+
+    uint64_to_value(value, 91431);
+    memset(text, '\0', sizeof(text));
+    CHECK(to_base10_100m(text, value, sizeof(text)) == SW_OK);
+    CHECK_STR(text, "00.00091431");
+    CHECK(value_to_uint64(value) == 91431);
+
+    // 18 digits, the decimal point and the null take 20 characters.
+    uint64_to_value(value, 100000000000000000ULL);
+    memset(text, 'x', sizeof(text));
+    CHECK(to_base10_100m(text, value, 20) == SW_OK);
+    CHECK_STR(text, "1000000000.00000000");
+    CHECK(to_base10_100m(text, value, 19) == 0x6D14);
+
+    // the largest value has 20 digits, one too many for 21 characters.
+    uint64_to_value(value, UINT64_MAX);
+    CHECK(to_base10_100m(text, value, 21) == 0x6D14);
+
+    // and it fits VALUE_BASE10_LEN.
+    char largest[VALUE_BASE10_LEN];
+    CHECK(to_base10_100m(largest, value, sizeof(largest)) == SW_OK);
+    CHECK_STR(largest, "184467440737.09551615");
+}
+
+static void test_public_key_to_script_hash(void) {
+    unsigned char public_key[65];
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    unsigned char expected[SCRIPT_HASH_LEN];
+    public_key[0] = 0x04;
+    for (unsigned int ix = 1; ix < sizeof(public_key); ix++) {
+        public_key[ix] = ix;
+    }
+    from_hex("e9ea06247d12907165114b8359f9b403cb0bc23c", expected, sizeof(expected));
+
+    public_key_to_script_hash(public_key, script_hash);
+    CHECK(memcmp(script_hash, expected, sizeof(expected)) == 0);
+}
+
+static void test_display_send_gas(void) {
+    load_raw_tx(TX_SEND_GAS);
+    CHECK(display_tx_desc() == SW_OK);
+    CHECK(tx_summary.tx_type == TX_CONTRACT);
+    CHECK(tx_summary.num_tx_outs == 2);
+    CHECK(tx_summary.asset_label == ASSET_LABEL_GAS);
+    CHECK(value_to_uint64(tx_summary.value) == 100000);
+    CHECK(max_scr_ix == 5);
+
+    CHECK_STR(tx_desc[0][1], "Contract Tx");
+    CHECK_STR(tx_desc[1][0], "GAS");
+    CHECK_STR(tx_desc[1][1], "000.00100000");
+    CHECK_STR(screen_text(2), "AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT");
+    CHECK_STR(tx_desc[3][1], "00.00081890");
+    CHECK_STR(screen_text(4), "AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT");
+}
+
+static void test_display_send_neo(void) {
+    load_raw_tx(TX_SEND_NEO);
+    CHECK(display_tx_desc() == SW_OK);
+    CHECK(tx_summary.num_tx_outs == 1);
+    CHECK(tx_summary.asset_label == ASSET_LABEL_NEO);
+    CHECK_STR(tx_desc[1][0], "NEO");
+    CHECK_STR(tx_desc[1][1], "00001.00000000");
+}
+
+static void test_display_claim_gas(void) {
+    load_raw_tx(TX_CLAIM_GAS);
+    CHECK(display_tx_desc() == SW_OK);
+    CHECK(tx_summary.tx_type == TX_CLAIM);
+    CHECK_STR(tx_desc[0][1], "Claim Tx");
+    CHECK_STR(tx_desc[1][1], "00.00091431");
+}
+
+static void test_display_errors(void) {
+    // a transaction cut in its inputs
+    load_raw_tx(TX_SEND_NEO);
+    raw_tx_len = 30;
+    CHECK(display_tx_desc() == 0x6D03);
+
+    // an unknown transaction type
+    load_raw_tx("99");
+    CHECK(display_tx_desc() == 0x6D06);
+}
+
+static void test_throw_is_caught(void) {
+    volatile bool caught = false;
+    BEGIN_TRY {
+        TRY {
+            THROW(0x6D00);
+        }
+        CATCH(0x6D00) {
+            caught = true;
+        }
+        FINALLY {
+        }
+    }
+    END_TRY;
+    CHECK(caught);
+    CHECK(G_try_context == NULL);
+}
+
+int main(void) {
+    test_to_address();
+    test_to_base10_100m();
+    test_public_key_to_script_hash();
+    test_display_send_gas();
+    test_display_send_neo();
+    test_display_claim_gas();
+    test_display_errors();
+    test_throw_is_caught();
+
+    if (failures != 0) {
+        fprintf(stderr, "%u checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** checks that the batches of neo_address give the script hashes and addresses of the device code
+ * in neo.c, bit for bit. */
+
+#include <stdlib.h>
+#include "neo.h"
+#include "neo_address.h"
+#include "tx_vectors.h"
+
+/** the keys checked, not a multiple of NEO_ADDRESS_LANES so that the last batch is partial. */
+#define KEY_COUNT 10003
+
+/** the number of checks that failed. */
+static unsigned int failures;
+
+/** a pseudo random byte, the same on every run. */
+static unsigned char next_byte(void) {
+    static uint32_t state = 0x12345678;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int main(void) {
+    unsigned char *public_keys = malloc(KEY_COUNT * NEO_PUBLIC_KEY_LEN);
+    unsigned char *script_hashes = malloc(KEY_COUNT * NEO_SCRIPT_HASH_LEN);
+    char *addresses = malloc(KEY_COUNT * (NEO_ADDRESS_LEN + 1));
+    char *script_hash_addresses = malloc(KEY_COUNT * (NEO_ADDRESS_LEN + 1));
+    if ((public_keys == NULL) || (script_hashes == NULL) || (addresses == NULL) ||
+        (script_hash_addresses == NULL)) {
+        return EXIT_FAILURE;
+    }
+    for (unsigned int ix = 0; ix < KEY_COUNT * NEO_PUBLIC_KEY_LEN; ix++) {
+        public_keys[ix] = (ix % NEO_PUBLIC_KEY_LEN == 0) ? 0x04 : next_byte();
+    }
+    // a script hash with leading zero bytes, which base58 encodes on their own.
+    memset(public_keys, 0, NEO_PUBLIC_KEY_LEN);
+
+    neo_script_hashes(public_keys, KEY_COUNT, script_hashes);
+    neo_addresses(public_keys, KEY_COUNT, addresses);
+    neo_script_hash_addresses(script_hashes, KEY_COUNT, script_hash_addresses);
+
+    for (unsigned int ix = 0; ix < KEY_COUNT; ix++) {
+        unsigned char script_hash[SCRIPT_HASH_LEN];
+        char address[ADDRESS_BASE58_LEN + 1];
+        public_key_to_script_hash(public_keys + (ix * NEO_PUBLIC_KEY_LEN), script_hash);
+        memset(address, '\0', sizeof(address));
+        if ((to_address(address, sizeof(address), script_hash) != SW_OK) ||
+            (memcmp(script_hash, script_hashes + (ix * NEO_SCRIPT_HASH_LEN), SCRIPT_HASH_LEN) !=
+             0) ||
+            (strcmp(address, addresses + (ix * (NEO_ADDRESS_LEN + 1))) != 0) ||
+            (strcmp(address, script_hash_addresses + (ix * (NEO_ADDRESS_LEN + 1))) != 0)) {
+            fprintf(stderr,
+                    "key %u: %s is not %s\n",
+                    ix,
+                    addresses + (ix * (NEO_ADDRESS_LEN + 1)),
+                    address);
+            failures++;
+        }
+    }
+
+    // the address of the tests' transactions.
+    unsigned char script_hash[NEO_SCRIPT_HASH_LEN];
+    char address[NEO_ADDRESS_LEN + 1];
+    from_hex(SCRIPT_HASH_AHXSMB, script_hash, sizeof(script_hash));
+    neo_script_hash_addresses(script_hash, 1, address);
+    if (strcmp(address, "AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT") != 0) {
+        fprintf(stderr, "%s is not AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT\n", address);
+        failures++;
+    }
+
+    free(public_keys);
+    free(script_hashes);
+    free(addresses);
+    free(script_hash_addresses);
+    if (failures != 0) {
+        fprintf(stderr, "%u checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,382 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** unit tests of the Exchange app's calls of swap.c, built for the host. the calls go through
+ * swap_library_main, as the Exchange app makes them, and the payout through swap_sign_tx_and_exit
+ * after display_tx_desc parsed it, as main.c calls them. signing, IO and the return to the Exchange
+ * app are stand-ins that record what swap.c asked for. */
+
+#include <stdlib.h>
+#include "swap.h"
+#include "crypto_helpers.h"
+#include "tx_vectors.h"
+
+/** the number of checks that failed. */
+static unsigned int failures;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                    #cond);                                                   \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+#define CHECK_STR(actual, expected)                                                   \
+    do {                                                                              \
+        if (strcmp((actual), (expected)) != 0) {                                      \
+            fprintf(stderr, "%s:%d: '%s' is not '%s'\n", __FILE__, __LINE__, (actual), \
+                    (expected));                                                      \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+/** the asset ids of NEO and GAS, as transactions hold them. */
+#define ASSET_NEO "9b7cffdaa674beae0f930ebe6085af9093e5fe56b34a5c220ccdcf6efc336fc5"
+#define ASSET_GAS "e72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60"
+
+/** the BIP44 path m/44'/888'/0'/0/0 and m/44'/888'/0'/0/1, as they follow a transaction. */
+#define PATH_0 "8000002c800003788000000000000000" "00000000"
+#define PATH_1 "8000002c800003788000000000000000" "00000001"
+
+/** the one input of the transactions, the inputs are not checked. */
+#define TX_INPUT "8d121f4bc2bf104e547e85d680780fe629c2b3ce89ac73e0ff02feb572bb98e0" "0000"
+
+/** the payout the Exchange app agrees on in the tests: 1 NEO to AHXSMB, with a fee of 0.001 GAS. */
+#define PAYOUT_AMOUNT 100000000
+#define PAYOUT_FEE 100000
+
+/** the stand-ins' record of what swap.c asked for. */
+static unsigned int signed_count;
+static unsigned short sign_sw;
+static unsigned int io_count;
+static unsigned short io_sw;
+static unsigned int lib_end_count;
+
+signing_context_t signing_ctx;
+
+/** the key of a path is made up from its hash, the host builds hold no seed. */
+cx_err_t bip32_derive_get_pubkey_256(cx_curve_t curve,
+                                     const uint32_t *path,
+                                     size_t path_len,
+                                     uint8_t raw_pubkey[static 65],
+                                     uint8_t *chain_code,
+                                     cx_md_t hashID) {
+    UNUSED(curve);
+    UNUSED(chain_code);
+    UNUSED(hashID);
+    raw_pubkey[0] = 0x04;
+    cx_hash_sha256((const uint8_t *) path, path_len * sizeof(uint32_t), raw_pubkey + 1, 32);
+    cx_hash_sha256(raw_pubkey + 1, 32, raw_pubkey + 33, 32);
+    return CX_OK;
+}
+
+unsigned short sign_tx_and_send(void) {
+    signed_count++;
+    io_sw = sign_sw;
+    return sign_sw;
+}
+
+void clear_signing_context(void) {
+    memset(&signing_ctx, 0, sizeof(signing_ctx));
+}
+
+unsigned int append_status_word(unsigned int tx, unsigned short sw) {
+    G_io_apdu_buffer[tx] = sw >> 8;
+    G_io_apdu_buffer[tx + 1] = sw;
+    return tx + 2;
+}
+
+unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len) {
+    UNUSED(channel_and_flags);
+    io_count++;
+    io_sw = (G_io_apdu_buffer[tx_len - 2] << 8) | G_io_apdu_buffer[tx_len - 1];
+    return 0;
+}
+
+void os_lib_end(void) {
+    lib_end_count++;
+}
+
+/** writes the hex of a script hash to hex, which has room for it. */
+static void script_hash_hex(const unsigned char *script_hash, char *hex) {
+    for (unsigned int ix = 0; ix < SCRIPT_HASH_LEN; ix++) {
+        sprintf(hex + (2 * ix), "%02x", script_hash[ix]);
+    }
+}
+
+/** the script hash of the key at a path in hex, as swap.c derives it. */
+static void path_script_hash_hex(const char *path_hex, char *hex) {
+    unsigned char path[BIP44_BYTE_LENGTH];
+    uint32_t bip44_path[BIP44_PATH_LEN];
+    unsigned char public_key[65];
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    from_hex(path_hex, path, sizeof(path));
+    for (unsigned int ix = 0; ix < BIP44_PATH_LEN; ix++) {
+        bip44_path[ix] = (path[4 * ix] << 24) | (path[(4 * ix) + 1] << 16) |
+                         (path[(4 * ix) + 2] << 8) | path[(4 * ix) + 3];
+    }
+    bip32_derive_get_pubkey_256(CX_CURVE_256R1, bip44_path, BIP44_PATH_LEN, public_key, NULL,
+                                CX_SHA512);
+    public_key_to_script_hash(public_key, script_hash);
+    script_hash_hex(script_hash, hex);
+}
+
+/** an output in hex: the asset id, the value in little endian, then the script hash. */
+static void output_hex(char *out, const char *asset, uint64_t value, const char *script_hash) {
+    out += sprintf(out, "%s", asset);
+    for (unsigned int ix = 0; ix < VALUE_LEN; ix++) {
+        out += sprintf(out, "%02x", (unsigned int) ((value >> (8 * ix)) & 0xFF));
+    }
+    sprintf(out, "%s", script_hash);
+}
+
+/** the Exchange app's call to sign the payout, with a coin configuration of NEO or GAS. */
+static bool start_payout(create_transaction_parameters_t *params,
+                         const char *ticker,
+                         unsigned char *amount,
+                         unsigned char *fee) {
+    static char destination[] = "AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT";
+    uint64_to_value(amount, PAYOUT_AMOUNT);
+    uint64_to_value(fee, PAYOUT_FEE);
+    // amounts are big endian for the Exchange app, values little endian in transactions.
+    for (unsigned int ix = 0; ix < VALUE_LEN / 2; ix++) {
+        unsigned char byte = amount[ix];
+        amount[ix] = amount[VALUE_LEN - 1 - ix];
+        amount[VALUE_LEN - 1 - ix] = byte;
+        byte = fee[ix];
+        fee[ix] = fee[VALUE_LEN - 1 - ix];
+        fee[VALUE_LEN - 1 - ix] = byte;
+    }
+
+    memset(params, 0, sizeof(*params));
+    params->coin_configuration = (uint8_t *) ticker;
+    params->coin_configuration_length = strlen(ticker);
+    params->amount = amount;
+    params->amount_length = VALUE_LEN;
+    params->fee_amount = fee;
+    params->fee_amount_length = VALUE_LEN;
+    params->destination_address = destination;
+    params->result = 0xFF;
+
+    libargs_t args = {.id = 0x100, .command = SIGN_TRANSACTION};
+    args.create_transaction = params;
+    return swap_library_main(&args);
+}
+
+/** parses the contract transaction with the outputs in hex, followed by the path, signs it as the
+ * payout with key_count keys, and returns the result the Exchange app gets. */
+static uint8_t sign_payout(const char *ticker,
+                           const char *outputs,
+                           unsigned char output_count,
+                           uint64_t fee,
+                           unsigned char key_count) {
+    create_transaction_parameters_t params;
+    unsigned char amount[VALUE_LEN];
+    unsigned char fee_amount[VALUE_LEN];
+    CHECK(start_payout(&params, ticker, amount, fee_amount));
+    CHECK(params.result == 0);
+    CHECK(swap.active);
+
+    char hex[2 * MAX_TX_RAW_LENGTH];
+    sprintf(hex, "800000" "01" TX_INPUT "%02x%s" PATH_0, output_count, outputs);
+    load_raw_tx(hex);
+    memset(&tx_summary, 0, sizeof(tx_summary));
+    CHECK(display_tx_desc() == SW_OK);
+    // the host builds hold no attestations, the fee is the one attested inputs would give.
+    tx_summary.fee_known = true;
+    tx_summary.fee = fee;
+
+    memset(&signing_ctx, 0, sizeof(signing_ctx));
+    from_hex(PATH_0, signing_ctx.bip44_path, sizeof(signing_ctx.bip44_path));
+    signing_ctx.key_count = key_count;
+    signing_ctx.multi_sign = (key_count > 1);
+
+    signed_count = 0;
+    io_count = 0;
+    io_sw = 0;
+    lib_end_count = 0;
+    params.result = 0xFF;
+    swap_sign_tx_and_exit();
+    CHECK(!swap.active);
+    CHECK(lib_end_count == 1);
+    CHECK((signed_count + io_count) == 1);
+    return params.result;
+}
+
+static void test_check_address(void) {
+    char change_hex[2 * SCRIPT_HASH_LEN + 1];
+    unsigned char script_hash[SCRIPT_HASH_LEN];
+    char address[ADDRESS_BASE58_LEN + 1];
+    path_script_hash_hex(PATH_0, change_hex);
+    from_hex(change_hex, script_hash, sizeof(script_hash));
+    memset(address, '\0', sizeof(address));
+    CHECK(to_address(address, sizeof(address), script_hash) == SW_OK);
+
+    unsigned char address_parameters[1 + BIP44_BYTE_LENGTH];
+    address_parameters[0] = BIP44_PATH_LEN;
+    from_hex(PATH_0, address_parameters + 1, BIP44_BYTE_LENGTH);
+
+    check_address_parameters_t params;
+    memset(&params, 0, sizeof(params));
+    params.address_parameters = address_parameters;
+    params.address_parameters_length = sizeof(address_parameters);
+    params.address_to_check = address;
+    libargs_t args = {.id = 0x100, .command = CHECK_ADDRESS};
+    args.check_address = &params;
+
+    CHECK(!swap_library_main(&args));
+    CHECK(params.result == 1);
+
+    // the address of another key.
+    from_hex(PATH_1, address_parameters + 1, BIP44_BYTE_LENGTH);
+    CHECK(!swap_library_main(&args));
+    CHECK(params.result == 0);
+
+    // a path that is not a BIP44 path of 5 levels.
+    from_hex(PATH_0, address_parameters + 1, BIP44_BYTE_LENGTH);
+    address_parameters[0] = 4;
+    params.result = 1;
+    CHECK(!swap_library_main(&args));
+    CHECK(params.result == 0);
+    address_parameters[0] = BIP44_PATH_LEN;
+    params.address_parameters_length = BIP44_BYTE_LENGTH;
+    params.result = 1;
+    CHECK(!swap_library_main(&args));
+    CHECK(params.result == 0);
+
+    // a call that is not the Exchange app's.
+    params.address_parameters_length = sizeof(address_parameters);
+    params.result = 0;
+    args.id = 0x101;
+    CHECK(!swap_library_main(&args));
+    CHECK(params.result == 0);
+}
+
+static void test_get_printable_amount(void) {
+    unsigned char amount[] = {0x05, 0xF5, 0xE1, 0x00};
+    get_printable_amount_parameters_t params;
+    memset(&params, 0, sizeof(params));
+    params.amount = amount;
+    params.amount_length = sizeof(amount);
+    libargs_t args = {.id = 0x100, .command = GET_PRINTABLE_AMOUNT};
+    args.get_printable_amount = &params;
+
+    // no coin configuration is NEO, the app's own coin.
+    CHECK(!swap_library_main(&args));
+    CHECK_STR(params.printable_amount, "NEO 00001.00000000");
+
+    params.coin_configuration = (uint8_t *) "GAS";
+    params.coin_configuration_length = 3;
+    CHECK(!swap_library_main(&args));
+    CHECK_STR(params.printable_amount, "GAS 00001.00000000");
+
+    // fees are in GAS, whatever the asset.
+    params.coin_configuration = (uint8_t *) "NEO";
+    params.is_fee = true;
+    CHECK(!swap_library_main(&args));
+    CHECK_STR(params.printable_amount, "GAS 00001.00000000");
+
+    params.coin_configuration = (uint8_t *) "ONT";
+    params.is_fee = false;
+    CHECK(!swap_library_main(&args));
+    CHECK_STR(params.printable_amount, "");
+
+    // an amount of more than 64 bits.
+    unsigned char large[9] = {0x01};
+    params.coin_configuration = (uint8_t *) "NEO";
+    params.amount = large;
+    params.amount_length = sizeof(large);
+    CHECK(!swap_library_main(&args));
+    CHECK_STR(params.printable_amount, "");
+}
+
+static void test_sign_transaction_parameters(void) {
+    create_transaction_parameters_t params;
+    unsigned char amount[VALUE_LEN];
+    unsigned char fee[VALUE_LEN];
+
+    CHECK(!start_payout(&params, "ONT", amount, fee));
+    CHECK(params.result == 0);
+    CHECK(!swap.active);
+
+    start_payout(&params, "NEO", amount, fee);
+    params.destination_address = NULL;
+    libargs_t args = {.id = 0x100, .command = SIGN_TRANSACTION};
+    args.create_transaction = &params;
+    CHECK(!swap_library_main(&args));
+    CHECK(!swap.active);
+}
+
+static void test_sign_payout(void) {
+    char change[2 * SCRIPT_HASH_LEN + 1];
+    char other[2 * SCRIPT_HASH_LEN + 1];
+    char outputs[4 * 2 * TX_OUTPUT_LEN + 1];
+    path_script_hash_hex(PATH_0, change);
+    path_script_hash_hex(PATH_1, other);
+
+    // the payout, with its change. an output ends the hex, so the first one is written first.
+    output_hex(outputs, ASSET_NEO, PAYOUT_AMOUNT, SCRIPT_HASH_AHXSMB);
+    output_hex(outputs + (2 * TX_OUTPUT_LEN), ASSET_GAS, 500000, change);
+    sign_sw = SW_OK;
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 1);
+    CHECK(signed_count == 1);
+
+    // a payout the signature of which fails.
+    sign_sw = 0x6D08;
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(signed_count == 1);
+    sign_sw = SW_OK;
+
+    // the wrong fee.
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE + 1, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // the wrong asset.
+    CHECK(sign_payout("GAS", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // signed with two keys.
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 2) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // the wrong amount, NEO is indivisible.
+    output_hex(outputs, ASSET_NEO, 2 * PAYOUT_AMOUNT, SCRIPT_HASH_AHXSMB);
+    output_hex(outputs + (2 * TX_OUTPUT_LEN), ASSET_GAS, 500000, change);
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // two payouts, which pay twice the amount.
+    output_hex(outputs, ASSET_NEO, PAYOUT_AMOUNT, SCRIPT_HASH_AHXSMB);
+    output_hex(outputs + (2 * TX_OUTPUT_LEN), ASSET_NEO, PAYOUT_AMOUNT, SCRIPT_HASH_AHXSMB);
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // change to another key than the signing one.
+    output_hex(outputs, ASSET_NEO, PAYOUT_AMOUNT, SCRIPT_HASH_AHXSMB);
+    output_hex(outputs + (2 * TX_OUTPUT_LEN), ASSET_GAS, 500000, other);
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+
+    // only change, no payout.
+    output_hex(outputs, ASSET_NEO, PAYOUT_AMOUNT, change);
+    output_hex(outputs + (2 * TX_OUTPUT_LEN), ASSET_GAS, 500000, change);
+    CHECK(sign_payout("NEO", outputs, 2, PAYOUT_FEE, 1) == 0);
+    CHECK(io_sw == 0x6D1D);
+}
+
+int main(void) {
+    test_check_address();
+    test_get_printable_amount();
+    test_sign_transaction_parameters();
+    test_sign_payout();
+
+    if (failures != 0) {
+        fprintf(stderr, "%u checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+/*
+ * MIT License, see root folder for full license.
+ */
+
+/** the transactions of the host tests and benchmark, the ones test/test_GAS_NEO.py signs. */
+#ifndef TX_VECTORS_H
+#define TX_VECTORS_H
+
+#include <stdio.h>
+#include "neo.h"
+
+/** contract transaction sending 0.001 GAS to AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT, and the change. */
+#define TX_SEND_GAS \
+    "8000000185e7e907cc5c5683e7fc926ba4be613d1810aebe14686b3675ee27d2476e5201000002e72d286979" \
+    "ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60a08601000000000013354f4f5d3f989a22" \
+    "1c794271e0bb2471c2735ee72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c60e2" \
+    "3f01000000000013354f4f5d3f989a221c794271e0bb2471c2735e"
+
+/** contract transaction sending 1 NEO to AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT. */
+#define TX_SEND_NEO \
+    "800000018d121f4bc2bf104e547e85d680780fe629c2b3ce89ac73e0ff02feb572bb98e00000019b7cffdaa6" \
+    "74beae0f930ebe6085af9093e5fe56b34a5c220ccdcf6efc336fc500e1f5050000000013354f4f5d3f989a22" \
+    "1c794271e0bb2471c2735e"
+
+/** claim transaction of 0.00091431 GAS to AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT. */
+#define TX_CLAIM_GAS \
+    "0200048d121f4bc2bf104e547e85d680780fe629c2b3ce89ac73e0ff02feb572bb98e00000e47d4e3d0563a5" \
+    "3232466fa7752b28db6c0485ee79e57dacb2646418f4e7ffd400002101dd269ec13b66360b29eb6ac78ba44b" \
+    "772b2b6369b7dd5ff8dcd5dd1aafa00000a5c04ecb7ff482474062fe0cbe030e653c77d28545a38490780f33" \
+    "be7469cdae0000000001e72d286979ee6cb1b7e65dfddfb2e384100b8d148e7758de42e4168b71792c602765" \
+    "01000000000013354f4f5d3f989a221c794271e0bb2471c2735e"
+
+/** the script hash of AHXSMB19pWytwJ7vzvCw5aWmd1DUniDKRT. */
+#define SCRIPT_HASH_AHXSMB "13354f4f5d3f989a221c794271e0bb2471c2735e"
+
+/** writes the bytes of hex to out, returns their number. */
+static inline unsigned int from_hex(const char *hex, unsigned char *out, unsigned int out_len) {
+    unsigned int len = 0;
+    while ((hex[2 * len] != '\0') && (len < out_len)) {
+        sscanf(hex + (2 * len), "%2hhx", &out[len]);
+        len++;
+    }
+    return len;
+}
+
+/** loads the transaction in hex into raw_tx, as the last part of an upload leaves it. */
+static inline void load_raw_tx(const char *hex) {
+    raw_tx_len = from_hex(hex, raw_tx, sizeof(raw_tx));
+    raw_tx_ix = 0;
+}
+
+#endif  // TX_VECTORS_H